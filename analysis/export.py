@@ -20,8 +20,8 @@ def tune(queue, table, operator, N):
     if operator.casefold() == "max" or operator.casefold() == "min":
         m_range = manage.get_M_range(queue, table, N)
         for m in m_range:
-            queue.execute("SELECT itemsPerBlock,GBS,time,time_err,cov FROM " + table + " WHERE (GBS = (SELECT " + operator + "(GBS) FROM " + table + " WHERE (M = " + str(m[0]) + " AND N = " + N + ")) AND (M = " + str(m[0]) + " AND N = " + N + "))")
+            queue.execute("SELECT tileWidth,tileHeight,itemsPerThread,localPadding,vectorWidth,directWrite,diagonal,GBS,time,time_err,cov FROM " + table + " WHERE (GBS = (SELECT " + operator + "(GBS) FROM " + table + " WHERE (M = " + str(m[0]) + " AND N = " + N + ")) AND (M = " + str(m[0]) + " AND N = " + N + "))")
             best = queue.fetchall()
-            confs.append([m[0], best[0][0], best[0][1], best[0][2], best[0][3], best[0][4]])
+            confs.append([m[0], best[0][0], best[0][1], best[0][2], best[0][3], best[0][4], best[0][5], best[0][6], best[0][7], best[0][8], best[0][9]])
     return confs
 
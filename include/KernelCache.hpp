@@ -0,0 +1,95 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <mutex>
+#include <cstdint>
+
+#include <InitializeOpenCL.hpp>
+#include <Kernel.hpp>
+#include <utils.hpp>
+
+
+#ifndef KERNEL_CACHE_HPP
+#define KERNEL_CACHE_HPP
+
+namespace isa {
+namespace OpenCL {
+
+// Version of the code generators of this library, part of every cache key; bump it whenever a generator changes its output,
+// otherwise cache directories keep mapping configurations to the sources of the old generator and run stale kernels
+const unsigned int kernelGeneratorVersion = 1;
+
+// Cache of compiled OpenCL programs, in memory and optionally on disk; kernels can be requested from multiple threads
+class kernelCache {
+public:
+  // An empty directory keeps the cache in memory only
+  kernelCache(const std::string & directory);
+  ~kernelCache();
+
+  // Get a kernel; the generator is called only if no binary is known for this configuration
+  cl::Kernel * getKernel(const std::string & name, const std::string & configuration, std::function< std::string * () > generator, const std::string & options, cl::Context & clContext, cl::Device & clDevice);
+  // Statistics, getLastHit() and getLastTime() refer to the last call to return
+  unsigned int getNrHits() const;
+  unsigned int getNrMisses() const;
+  bool getLastHit() const;
+  double getLastTime() const;
+
+private:
+  std::string directory;
+  // Configuration key -> hash of the generated source
+  std::map< std::string, std::string > sources;
+  // Binary key -> program binary
+  std::map< std::string, std::vector< unsigned char > > binaries;
+  unsigned int nrHits;
+  unsigned int nrMisses;
+  bool lastHit;
+  double lastTime;
+  std::mutex cacheMutex;
+
+  bool loadBinary(const std::string & key, std::vector< unsigned char > & binary);
+  void storeBinary(const std::string & key, const std::vector< unsigned char > & binary);
+  // Forget a binary that does not build, in memory and on disk
+  void dropBinary(const std::string & key);
+};
+
+// 64 bit FNV-1a hash, in hexadecimal
+std::string hashString(const std::string & text);
+
+
+// Implementations
+
+inline unsigned int kernelCache::getNrHits() const {
+  return nrHits;
+}
+
+inline unsigned int kernelCache::getNrMisses() const {
+  return nrMisses;
+}
+
+inline bool kernelCache::getLastHit() const {
+  return lastHit;
+}
+
+inline double kernelCache::getLastTime() const {
+  return lastTime;
+}
+
+} // OpenCL
+} // isa
+
+#endif // KERNEL_CACHE_HPP
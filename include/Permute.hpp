@@ -0,0 +1,152 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+
+#include <utils.hpp>
+#include <Transpose.hpp>
+
+
+#ifndef PERMUTE_HPP
+#define PERMUTE_HPP
+
+namespace isa {
+namespace OpenCL {
+
+// Axis 0 of a tensor is the outermost and the last axis is contiguous in memory; every axis is padded to a multiple of its padding.
+// Axis i of the permuted tensor is axis permutation[i] of the input.
+
+// Parse a comma separated list of axes, e.g. "0,2,1"
+std::vector< unsigned int > readPermuteAxes(const std::string & axes);
+// Shape of the permuted tensor, throws std::invalid_argument if permutation is not valid for shape
+std::vector< unsigned int > getPermuteShape(const std::vector< unsigned int > & shape, const std::vector< unsigned int > & permutation);
+// Stride of every axis, in elements
+std::vector< std::size_t > getPermuteStrides(const std::vector< unsigned int > & shape, const std::vector< unsigned int > & padding);
+// Padding of a tensor where only the contiguous axis is padded
+std::vector< unsigned int > getPermutePadding(const unsigned int nrAxes, const unsigned int padding);
+// Elements in memory, padding included
+std::size_t getPermuteSize(const std::vector< unsigned int > & shape, const std::vector< unsigned int > & padding);
+// Sequential permutation
+template< typename T > void permute(const std::vector< unsigned int > & shape, const std::vector< unsigned int > & inputPadding, const std::vector< unsigned int > & permutation, const std::vector< unsigned int > & outputPadding, std::vector< T > & input, std::vector< T > & output);
+// Tiled and multithreaded permutation (nrThreads = 0 uses all hardware threads)
+template< typename T > void permute(const std::vector< unsigned int > & shape, const std::vector< unsigned int > & inputPadding, const std::vector< unsigned int > & permutation, const std::vector< unsigned int > & outputPadding, std::vector< T > & input, std::vector< T > & output, const unsigned int tile, unsigned int nrThreads);
+// OpenCL permutation in a single pass; the axis contiguous in the input is tiled against the one contiguous in the output, the other axes are the third dimension of the NDRange
+std::string * getPermuteOpenCL(const transposeConf & conf, const std::vector< unsigned int > & shape, const std::vector< unsigned int > & inputPadding, const std::vector< unsigned int > & permutation, const std::vector< unsigned int > & outputPadding, const unsigned int vector, std::string typeName);
+// Global size of the OpenCL permutation; the local size is (conf.getNrThreads(), 1, 1)
+std::vector< unsigned int > getPermuteGlobalSize(const transposeConf & conf, const std::vector< unsigned int > & shape, const std::vector< unsigned int > & permutation);
+
+
+// Implementations
+
+template< typename T > void permute(const std::vector< unsigned int > & shape, const std::vector< unsigned int > & inputPadding, const std::vector< unsigned int > & permutation, const std::vector< unsigned int > & outputPadding, std::vector< T > & input, std::vector< T > & output) {
+  const std::vector< std::size_t > inputStrides = getPermuteStrides(shape, inputPadding);
+  const std::vector< std::size_t > outputStrides = getPermuteStrides(getPermuteShape(shape, permutation), outputPadding);
+  std::vector< unsigned int > index(shape.size(), 0);
+  std::size_t nrElements = 1;
+
+  for ( unsigned int axis = 0; axis < shape.size(); axis++ ) {
+    nrElements *= shape[axis];
+  }
+  for ( std::size_t element = 0; element < nrElements; element++ ) {
+    std::size_t inputItem = 0;
+    std::size_t outputItem = 0;
+
+    for ( unsigned int axis = 0; axis < shape.size(); axis++ ) {
+      inputItem += index[axis] * inputStrides[axis];
+      outputItem += index[permutation[axis]] * outputStrides[axis];
+    }
+    output[outputItem] = input[inputItem];
+    // Next index, the last axis is the fastest
+    for ( int axis = shape.size() - 1; axis >= 0; axis-- ) {
+      if ( ++index[axis] < shape[axis] ) {
+        break;
+      }
+      index[axis] = 0;
+    }
+  }
+}
+
+template< typename T > void permute(const std::vector< unsigned int > & shape, const std::vector< unsigned int > & inputPadding, const std::vector< unsigned int > & permutation, const std::vector< unsigned int > & outputPadding, std::vector< T > & input, std::vector< T > & output, const unsigned int tile, unsigned int nrThreads) {
+  const unsigned int nrAxes = shape.size();
+  const std::vector< std::size_t > inputStrides = getPermuteStrides(shape, inputPadding);
+  const std::vector< std::size_t > outputStrides = getPermuteStrides(getPermuteShape(shape, permutation), outputPadding);
+  // Axes contiguous in the input and in the output
+  const unsigned int inner = nrAxes - 1;
+  const unsigned int outer = permutation[nrAxes - 1];
+  std::vector< std::size_t > permutedStrides(nrAxes);
+  unsigned int nrSlices = 1;
+  std::atomic< unsigned int > nextSlice(0);
+  std::vector< std::thread > pool;
+
+  for ( unsigned int axis = 0; axis < nrAxes; axis++ ) {
+    permutedStrides[permutation[axis]] = outputStrides[axis];
+    if ( axis != inner && axis != outer ) {
+      nrSlices *= shape[axis];
+    }
+  }
+  if ( nrThreads == 0 ) {
+    nrThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  // A slice is a row if the contiguous axis does not move, a matrix to transpose otherwise
+  auto slice = [&](unsigned int sliceID, const unsigned int sliceThreads) {
+    std::size_t inputOffset = 0;
+    std::size_t outputOffset = 0;
+
+    for ( int axis = nrAxes - 1; axis >= 0; axis-- ) {
+      if ( static_cast< unsigned int >(axis) == inner || static_cast< unsigned int >(axis) == outer ) {
+        continue;
+      }
+      inputOffset += (sliceID % shape[axis]) * inputStrides[axis];
+      outputOffset += (sliceID % shape[axis]) * permutedStrides[axis];
+      sliceID /= shape[axis];
+    }
+    if ( inner == outer ) {
+      std::copy(input.begin() + inputOffset, input.begin() + inputOffset + shape[inner], output.begin() + outputOffset);
+    } else {
+      transpose(shape[outer], shape[inner], input.data() + inputOffset, inputStrides[outer], output.data() + outputOffset, permutedStrides[inner], tile, sliceThreads);
+    }
+  };
+
+  if ( nrSlices < nrThreads ) {
+    // Few large slices, parallel inside each one
+    for ( unsigned int sliceID = 0; sliceID < nrSlices; sliceID++ ) {
+      slice(sliceID, nrThreads);
+    }
+    return;
+  }
+  auto worker = [&]() {
+    for ( unsigned int sliceID = nextSlice++; sliceID < nrSlices; sliceID = nextSlice++ ) {
+      slice(sliceID, 1);
+    }
+  };
+
+  for ( unsigned int thread = 1; thread < nrThreads; thread++ ) {
+    pool.push_back(std::thread(worker));
+  }
+  worker();
+  for ( std::vector< std::thread >::iterator thread = pool.begin(); thread != pool.end(); ++thread ) {
+    thread->join();
+  }
+}
+
+} // OpenCL
+} // isa
+
+#endif // PERMUTE_HPP
@@ -16,6 +16,14 @@
 #include <string>
 #include <map>
 #include <fstream>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <limits>
+#include <cmath>
 
 #include <utils.hpp>
 
@@ -32,34 +40,197 @@ public:
   ~transposeConf();
 
   // Get
-  unsigned int getNrItemsPerBlock() const;
+  unsigned int getTileWidth() const;
+  unsigned int getTileHeight() const;
+  unsigned int getNrItemsPerThread() const;
+  unsigned int getLocalPadding() const;
+  unsigned int getVectorWidth() const;
+  unsigned int getDirectWrite() const;
+  unsigned int getDiagonal() const;
   // Set
-  void setNrItemsPerBlock(unsigned int items);
+  void setTileWidth(unsigned int width);
+  void setTileHeight(unsigned int height);
+  void setNrItemsPerThread(unsigned int items);
+  void setLocalPadding(unsigned int padding);
+  void setVectorWidth(unsigned int width);
+  void setDirectWrite(unsigned int direct);
+  void setDiagonal(unsigned int order);
   // utils
+  unsigned int getNrThreads() const;
   std::string print() const;
 
 private:
-  unsigned int nrItemsPerBlock;
+  // A tile is tileHeight rows of M by tileWidth columns of N
+  unsigned int tileWidth;
+  unsigned int tileHeight;
+  unsigned int nrItemsPerThread;
+  // Extra columns of the tile in local memory
+  unsigned int localPadding;
+  // Elements per global memory access
+  unsigned int vectorWidth;
+  // Store the tile transposed in local memory while loading it, instead of transposing it in local memory afterwards
+  unsigned int directWrite;
+  // Assign tiles to work-groups along the diagonals, to spread the accesses over the memory partitions
+  unsigned int diagonal;
 };
 
 typedef std::map< std::string, std::map< unsigned int, isa::OpenCL::transposeConf > > tunedTransposeConf;
 
+// Instruction sets available for the host register-tile kernels
+enum hostSIMD { SIMD_NONE = 0, SIMD_SSE, SIMD_AVX2, SIMD_AVX512 };
+// Transpose a square register tile; strides are in elements
+typedef void (* transposeTileKernel)(const void * input, const std::size_t inputStride, void * output, const std::size_t outputStride);
+// Host algorithms
+enum hostAlgorithm { HOST_NAIVE = 0, HOST_TILED, HOST_RECURSIVE };
+// Rows [beginM, endM) and columns [beginN, endN) of a matrix
+struct transposeBlock {
+  unsigned int beginM;
+  unsigned int endM;
+  unsigned int beginN;
+  unsigned int endN;
+};
+// Window of a row-major matrix with leadingDimension elements per row, starting at element (firstRow, firstColumn)
+struct matrixView {
+  unsigned int firstRow;
+  unsigned int firstColumn;
+  unsigned int leadingDimension;
+};
+// Side of the blocks the recursive transpose does not split any more, small enough for the L1 of any CPU
+const unsigned int transposeRecursiveBase = 32;
+// Elements of the blocks the recursive transpose gives to different threads
+const unsigned int transposeRecursiveGrain = 128 * 128;
+
 // Sequential transpose
 template< typename T > void transpose(const unsigned int M, const unsigned int N, const unsigned int padding, std::vector< T > & input, std::vector< T > & output);
-// OpenCL transpose
+// Tiled and multithreaded transpose (nrThreads = 0 uses all hardware threads)
+template< typename T > void transpose(const unsigned int M, const unsigned int N, const unsigned int padding, std::vector< T > & input, std::vector< T > & output, const unsigned int tile, unsigned int nrThreads);
+// Tiled and multithreaded transpose of raw memory; strides are in elements
+template< typename T > void transpose(const unsigned int M, const unsigned int N, const T * input, const std::size_t inputStride, T * output, const std::size_t outputStride, const unsigned int tile, unsigned int nrThreads);
+// Cache-oblivious transpose: the larger side is halved until blocks are at most transposeRecursiveBase x transposeRecursiveBase, with no tile to tune (nrThreads = 0 uses all hardware threads)
+template< typename T > void transposeRecursive(const unsigned int M, const unsigned int N, const unsigned int padding, std::vector< T > & input, std::vector< T > & output, unsigned int nrThreads);
+// Cache-oblivious transpose of raw memory; strides are in elements
+template< typename T > void transposeRecursive(const unsigned int M, const unsigned int N, const T * input, const std::size_t inputStride, T * output, const std::size_t outputStride, unsigned int nrThreads);
+// Sequential recursion on one block of the cache-oblivious transpose
+template< typename T > void transposeRecursiveBlock(const T * input, const std::size_t inputStride, T * output, const std::size_t outputStride, const transposeBlock & block, transposeTileKernel simdKernel, const unsigned int simdSize);
+// Transpose of raw memory with the chosen algorithm; tile is only used by HOST_TILED, nrThreads is not used by HOST_NAIVE
+template< typename T > void transposeHost(const hostAlgorithm algorithm, const unsigned int M, const unsigned int N, const T * input, const std::size_t inputStride, T * output, const std::size_t outputStride, const unsigned int tile, unsigned int nrThreads);
+template< typename T > void transposeHost(const hostAlgorithm algorithm, const unsigned int M, const unsigned int N, const unsigned int padding, std::vector< T > & input, std::vector< T > & output, const unsigned int tile, unsigned int nrThreads);
+// Transpose of the M x N window inputView of input into the N x M window outputView of output, the rest of output is not touched
+template< typename T > void transposeHost(const hostAlgorithm algorithm, const unsigned int M, const unsigned int N, const matrixView & inputView, std::vector< T > & input, const matrixView & outputView, std::vector< T > & output, const unsigned int tile, unsigned int nrThreads);
+// Parse "firstRow:firstColumn:leadingDimension"
+matrixView readMatrixView(const std::string & view);
+// Element of the matrix where the view starts
+std::size_t getMatrixViewOffset(const matrixView & view);
+// Elements of a matrix containing a view of rows rows
+std::size_t getMatrixViewSize(const unsigned int rows, const matrixView & view);
+// Throws std::out_of_range if the rows x columns view does not fit in a matrix of size elements
+void checkMatrixView(const unsigned int rows, const unsigned int columns, const matrixView & view, const std::size_t size);
+// Halve the larger side of block; the first half is a multiple of alignment when possible
+void splitTransposeBlock(const transposeBlock & block, const unsigned int alignment, transposeBlock & first, transposeBlock & second);
+// Split the M x N matrix with splitTransposeBlock() until blocks have at most grain elements, and process them on nrThreads work-stealing workers
+void processTransposeBlocks(const unsigned int M, const unsigned int N, const unsigned int grain, const unsigned int alignment, unsigned int nrThreads, const std::function< void(const transposeBlock & block) > & process);
+// Round to nearest and saturate when O is an integer, as convert_<type>_sat_rte() does in OpenCL
+template< typename O, typename C > O convertTransposeElement(const C value);
+// Tiled and multithreaded transpose converting I to O; unless scale is 1 and offset 0 every element becomes (element * scale) + offset, computed in double if O is double and in float otherwise
+template< typename I, typename O > void transpose(const unsigned int M, const unsigned int N, const unsigned int padding, std::vector< I > & input, std::vector< O > & output, const double scale, const double offset, const unsigned int tile, unsigned int nrThreads);
+// Batched transpose of nrBatches matrices, parallel over the batches; strides are in elements
+template< typename T > void transposeBatched(const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int nrBatches, const std::size_t inputBatchStride, const std::size_t outputBatchStride, std::vector< T > & input, std::vector< T > & output, const unsigned int tile, unsigned int nrThreads);
+// In-place transpose, data must hold max(M * pad(N, padding), N * pad(M, padding)) elements
+template< typename T > void transposeInPlace(const unsigned int M, const unsigned int N, const unsigned int padding, std::vector< T > & data, const unsigned int tile);
+// Size of the buffer needed by the in-place transpose
+unsigned int getTransposeInPlaceSize(const unsigned int M, const unsigned int N, const unsigned int padding);
+// First element of every non trivial permutation chain of the rectangular in-place transpose
+std::vector< unsigned int > getTransposeInPlaceLeaders(const unsigned int M, const unsigned int N, const unsigned int padding);
+// Best instruction set supported by the host CPU (CPUID)
+hostSIMD getHostSIMD();
+// Register-tile kernel for elements of typeSize bytes, or 0 if there is none; tileSize is set to the side of the tile
+transposeTileKernel getTransposeTileKernel(const std::size_t typeSize, unsigned int & tileSize, const hostSIMD simd = getHostSIMD());
+// OpenCL transpose; the generators below are cached by kernelCache, bump kernelGeneratorVersion when their output changes
 std::string * getTransposeOpenCL(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int vector, std::string typeName);
+// OpenCL transpose converting inputTypeName to outputTypeName; with scale the kernel takes two more arguments, scale and offset, applied to every element
+std::string * getTransposeOpenCL(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int vector, std::string inputTypeName, std::string outputTypeName, const bool scale);
+// Type of the scale and offset arguments
+std::string getTransposeScaleType(const std::string & outputTypeName);
+// Number of elements of an OpenCL vector type, 1 for scalars (float2 is 2, float is 1)
+unsigned int getTransposeTypeWidth(const std::string & typeName);
+// Type the kernels move elements of typeName as; half is moved as ushort, so that devices without cl_khr_fp16 can transpose it
+std::string getTransposeStorageType(const std::string & typeName);
+// Pragmas enabling the extensions needed by kernels using the two types (cl_khr_fp64 for double, cl_khr_fp16 for half)
+std::string getTransposeExtensions(const std::string & inputTypeName, const std::string & outputTypeName);
+// Body of the OpenCL transpose, for kernels that define input and output (and scale and offset, if used); strides are in elements
+std::string * getTransposeBody(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int inputStride, const unsigned int outputStride, const unsigned int vector, std::string inputTypeName, std::string outputTypeName, const bool scale);
+// OpenCL batched transpose, the batch is the third dimension of the NDRange; strides are in elements
+std::string * getTransposeBatchedOpenCL(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int vector, std::string typeName, const unsigned int inputBatchStride, const unsigned int outputBatchStride);
+// OpenCL transpose of a M x N view into a N x M view; the kernel takes two more arguments, the offsets in elements of the views in input and output
+std::string * getTransposeViewOpenCL(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int inputLeadingDimension, const unsigned int outputLeadingDimension, const unsigned int vector, std::string typeName);
+// OpenCL in-place transpose (blocked swap if M == N, cycle following otherwise)
+std::string * getTransposeInPlaceOpenCL(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int vector, std::string typeName);
+// OpenCL copy of nrElements elements, one work-item per element; the bandwidth baseline for the transpose
+std::string * getCopyOpenCL(const unsigned int nrElements, std::string typeName);
 // Read configuration files
 void readTunedTransposeConf(tunedTransposeConf & tunedTranspose, const std::string & transposeFilename);
 
 
 // Implementations
 
-inline unsigned int transposeConf::getNrItemsPerBlock() const {
-  return nrItemsPerBlock;
+inline unsigned int transposeConf::getTileWidth() const {
+  return tileWidth;
+}
+
+inline unsigned int transposeConf::getTileHeight() const {
+  return tileHeight;
+}
+
+inline unsigned int transposeConf::getNrItemsPerThread() const {
+  return nrItemsPerThread;
+}
+
+inline unsigned int transposeConf::getLocalPadding() const {
+  return localPadding;
+}
+
+inline unsigned int transposeConf::getVectorWidth() const {
+  return vectorWidth;
+}
+
+inline unsigned int transposeConf::getDirectWrite() const {
+  return directWrite;
+}
+
+inline unsigned int transposeConf::getDiagonal() const {
+  return diagonal;
+}
+
+inline void transposeConf::setTileWidth(unsigned int width) {
+  tileWidth = width;
+}
+
+inline void transposeConf::setTileHeight(unsigned int height) {
+  tileHeight = height;
+}
+
+inline void transposeConf::setNrItemsPerThread(unsigned int items) {
+  nrItemsPerThread = items;
+}
+
+inline void transposeConf::setLocalPadding(unsigned int padding) {
+  localPadding = padding;
+}
+
+inline void transposeConf::setVectorWidth(unsigned int width) {
+  vectorWidth = width;
+}
+
+inline void transposeConf::setDirectWrite(unsigned int direct) {
+  directWrite = direct;
+}
+
+inline void transposeConf::setDiagonal(unsigned int order) {
+  diagonal = order;
 }
 
-inline void transposeConf::setNrItemsPerBlock(unsigned int items) {
-  nrItemsPerBlock = items;
+inline unsigned int transposeConf::getNrThreads() const {
+  return (tileWidth * tileHeight) / nrItemsPerThread;
 }
 
 template< typename T > void transpose(const unsigned int M, const unsigned int N, const unsigned int padding, std::vector< T > & input, std::vector< T > & output) {
@@ -70,6 +241,268 @@ template< typename T > void transpose(const unsigned int M, const unsigned int N
   }
 }
 
+template< typename T > void transpose(const unsigned int M, const unsigned int N, const unsigned int padding, std::vector< T > & input, std::vector< T > & output, const unsigned int tile, unsigned int nrThreads) {
+  transpose(M, N, input.data(), isa::utils::pad(N, padding), output.data(), isa::utils::pad(M, padding), tile, nrThreads);
+}
+
+template< typename T > void transpose(const unsigned int M, const unsigned int N, const T * input, const std::size_t inputStride, T * output, const std::size_t outputStride, const unsigned int tile, unsigned int nrThreads) {
+  const unsigned int nrTilesM = (M + tile - 1) / tile;
+  const unsigned int nrTilesN = (N + tile - 1) / tile;
+  std::atomic< unsigned int > nextTile(0);
+  std::vector< std::thread > pool;
+
+  if ( nrThreads == 0 ) {
+    nrThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  nrThreads = std::min(nrThreads, nrTilesM * nrTilesN);
+
+  unsigned int simdSize = 0;
+  transposeTileKernel simdKernel = 0;
+
+  if ( std::is_trivially_copyable< T >::value ) {
+    simdKernel = getTransposeTileKernel(sizeof(T), simdSize);
+  }
+  auto scalarBlock = [&](const unsigned int beginM, const unsigned int endM, const unsigned int beginN, const unsigned int endN) {
+    for ( unsigned int i = beginM; i < endM; i++ ) {
+      const T * inputRow = input + (i * inputStride);
+      T * outputColumn = output + i;
+
+      for ( unsigned int j = beginN; j < endN; j++ ) {
+        outputColumn[j * outputStride] = inputRow[j];
+      }
+    }
+  };
+  // Each worker keeps taking the next tile until the matrix is done
+  auto worker = [&]() {
+    for ( unsigned int tileID = nextTile++; tileID < nrTilesM * nrTilesN; tileID = nextTile++ ) {
+      const unsigned int baseM = (tileID / nrTilesN) * tile;
+      const unsigned int baseN = (tileID % nrTilesN) * tile;
+      const unsigned int endM = std::min(baseM + tile, M);
+      const unsigned int endN = std::min(baseN + tile, N);
+      unsigned int i = baseM;
+
+      if ( simdKernel != 0 ) {
+        // Full register tiles, the edges of the tile are done in scalar code
+        for ( ; i + simdSize <= endM; i += simdSize ) {
+          unsigned int j = baseN;
+
+          for ( ; j + simdSize <= endN; j += simdSize ) {
+            simdKernel(input + (i * inputStride) + j, inputStride, output + (j * outputStride) + i, outputStride);
+          }
+          scalarBlock(i, i + simdSize, j, endN);
+        }
+      }
+      scalarBlock(i, endM, baseN, endN);
+    }
+  };
+
+  for ( unsigned int thread = 1; thread < nrThreads; thread++ ) {
+    pool.push_back(std::thread(worker));
+  }
+  worker();
+  for ( std::vector< std::thread >::iterator thread = pool.begin(); thread != pool.end(); ++thread ) {
+    thread->join();
+  }
+}
+
+template< typename T > void transposeRecursive(const unsigned int M, const unsigned int N, const unsigned int padding, std::vector< T > & input, std::vector< T > & output, unsigned int nrThreads) {
+  transposeRecursive(M, N, input.data(), isa::utils::pad(N, padding), output.data(), isa::utils::pad(M, padding), nrThreads);
+}
+
+template< typename T > void transposeRecursive(const unsigned int M, const unsigned int N, const T * input, const std::size_t inputStride, T * output, const std::size_t outputStride, unsigned int nrThreads) {
+  unsigned int simdSize = 1;
+  transposeTileKernel simdKernel = 0;
+
+  if ( std::is_trivially_copyable< T >::value ) {
+    simdKernel = getTransposeTileKernel(sizeof(T), simdSize);
+  }
+  // Blocks are split on multiples of the register tile, so that only the edges of the matrix are done in scalar code
+  processTransposeBlocks(M, N, transposeRecursiveGrain, simdSize, nrThreads, [&](const transposeBlock & block) {
+    transposeRecursiveBlock(input, inputStride, output, outputStride, block, simdKernel, simdSize);
+  });
+}
+
+template< typename T > void transposeRecursiveBlock(const T * input, const std::size_t inputStride, T * output, const std::size_t outputStride, const transposeBlock & block, transposeTileKernel simdKernel, const unsigned int simdSize) {
+  if ( (block.endM - block.beginM > transposeRecursiveBase) || (block.endN - block.beginN > transposeRecursiveBase) ) {
+    transposeBlock first;
+    transposeBlock second;
+
+    splitTransposeBlock(block, simdSize, first, second);
+    transposeRecursiveBlock(input, inputStride, output, outputStride, first, simdKernel, simdSize);
+    transposeRecursiveBlock(input, inputStride, output, outputStride, second, simdKernel, simdSize);
+    return;
+  }
+  unsigned int i = block.beginM;
+
+  if ( simdKernel != 0 ) {
+    for ( ; i + simdSize <= block.endM; i += simdSize ) {
+      unsigned int j = block.beginN;
+
+      for ( ; j + simdSize <= block.endN; j += simdSize ) {
+        simdKernel(input + (i * inputStride) + j, inputStride, output + (j * outputStride) + i, outputStride);
+      }
+      for ( unsigned int row = i; row < i + simdSize; row++ ) {
+        for ( unsigned int column = j; column < block.endN; column++ ) {
+          output[(column * outputStride) + row] = input[(row * inputStride) + column];
+        }
+      }
+    }
+  }
+  for ( ; i < block.endM; i++ ) {
+    for ( unsigned int j = block.beginN; j < block.endN; j++ ) {
+      output[(j * outputStride) + i] = input[(i * inputStride) + j];
+    }
+  }
+}
+
+template< typename T > void transposeHost(const hostAlgorithm algorithm, const unsigned int M, const unsigned int N, const T * input, const std::size_t inputStride, T * output, const std::size_t outputStride, const unsigned int tile, unsigned int nrThreads) {
+  switch ( algorithm ) {
+    case HOST_TILED:
+      transpose(M, N, input, inputStride, output, outputStride, tile, nrThreads);
+      break;
+    case HOST_RECURSIVE:
+      transposeRecursive(M, N, input, inputStride, output, outputStride, nrThreads);
+      break;
+    default:
+      for ( unsigned int i = 0; i < M; i++ ) {
+        for ( unsigned int j = 0; j < N; j++ ) {
+          output[(j * outputStride) + i] = input[(i * inputStride) + j];
+        }
+      }
+      break;
+  }
+}
+
+template< typename T > void transposeHost(const hostAlgorithm algorithm, const unsigned int M, const unsigned int N, const unsigned int padding, std::vector< T > & input, std::vector< T > & output, const unsigned int tile, unsigned int nrThreads) {
+  transposeHost(algorithm, M, N, input.data(), isa::utils::pad(N, padding), output.data(), isa::utils::pad(M, padding), tile, nrThreads);
+}
+
+template< typename T > void transposeHost(const hostAlgorithm algorithm, const unsigned int M, const unsigned int N, const matrixView & inputView, std::vector< T > & input, const matrixView & outputView, std::vector< T > & output, const unsigned int tile, unsigned int nrThreads) {
+  checkMatrixView(M, N, inputView, input.size());
+  checkMatrixView(N, M, outputView, output.size());
+  transposeHost(algorithm, M, N, input.data() + getMatrixViewOffset(inputView), inputView.leadingDimension, output.data() + getMatrixViewOffset(outputView), outputView.leadingDimension, tile, nrThreads);
+}
+
+template< typename O, typename C > inline O convertTransposeElement(const C value) {
+  if ( std::is_integral< O >::value ) {
+    const C rounded = std::nearbyint(value);
+
+    if ( rounded <= static_cast< C >(std::numeric_limits< O >::lowest()) ) {
+      return std::numeric_limits< O >::lowest();
+    } else if ( rounded >= static_cast< C >(std::numeric_limits< O >::max()) ) {
+      return std::numeric_limits< O >::max();
+    }
+    return static_cast< O >(rounded);
+  }
+  return static_cast< O >(value);
+}
+
+template< typename I, typename O > void transpose(const unsigned int M, const unsigned int N, const unsigned int padding, std::vector< I > & input, std::vector< O > & output, const double scale, const double offset, const unsigned int tile, unsigned int nrThreads) {
+  typedef typename std::conditional< std::is_same< O, double >::value, double, float >::type scaleType;
+  const bool scaled = (scale != 1.0) || (offset != 0.0);
+  const std::size_t inputStride = isa::utils::pad(N, padding);
+  const std::size_t outputStride = isa::utils::pad(M, padding);
+  const unsigned int nrTilesM = (M + tile - 1) / tile;
+  const unsigned int nrTilesN = (N + tile - 1) / tile;
+  std::atomic< unsigned int > nextTile(0);
+  std::vector< std::thread > pool;
+
+  if ( nrThreads == 0 ) {
+    nrThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  nrThreads = std::min(nrThreads, nrTilesM * nrTilesN);
+
+  // The conversion happens while the tile is in cache, so the data is read and written once
+  auto worker = [&]() {
+    for ( unsigned int tileID = nextTile++; tileID < nrTilesM * nrTilesN; tileID = nextTile++ ) {
+      const unsigned int baseM = (tileID / nrTilesN) * tile;
+      const unsigned int baseN = (tileID % nrTilesN) * tile;
+      const unsigned int endM = std::min(baseM + tile, M);
+      const unsigned int endN = std::min(baseN + tile, N);
+
+      for ( unsigned int i = baseM; i < endM; i++ ) {
+        for ( unsigned int j = baseN; j < endN; j++ ) {
+          const I item = input[(i * inputStride) + j];
+
+          if ( scaled ) {
+            output[(j * outputStride) + i] = convertTransposeElement< O >((static_cast< scaleType >(item) * static_cast< scaleType >(scale)) + static_cast< scaleType >(offset));
+          } else {
+            output[(j * outputStride) + i] = convertTransposeElement< O >(static_cast< double >(item));
+          }
+        }
+      }
+    }
+  };
+
+  for ( unsigned int thread = 1; thread < nrThreads; thread++ ) {
+    pool.push_back(std::thread(worker));
+  }
+  worker();
+  for ( std::vector< std::thread >::iterator thread = pool.begin(); thread != pool.end(); ++thread ) {
+    thread->join();
+  }
+}
+
+template< typename T > void transposeBatched(const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int nrBatches, const std::size_t inputBatchStride, const std::size_t outputBatchStride, std::vector< T > & input, std::vector< T > & output, const unsigned int tile, unsigned int nrThreads) {
+  std::atomic< unsigned int > nextBatch(0);
+  std::vector< std::thread > pool;
+
+  if ( nrThreads == 0 ) {
+    nrThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  nrThreads = std::min(nrThreads, nrBatches);
+
+  // The matrices are small, so every worker transposes whole matrices
+  auto worker = [&]() {
+    for ( unsigned int batch = nextBatch++; batch < nrBatches; batch = nextBatch++ ) {
+      transpose(M, N, input.data() + (batch * inputBatchStride), isa::utils::pad(N, padding), output.data() + (batch * outputBatchStride), isa::utils::pad(M, padding), tile, 1);
+    }
+  };
+
+  for ( unsigned int thread = 1; thread < nrThreads; thread++ ) {
+    pool.push_back(std::thread(worker));
+  }
+  worker();
+  for ( std::vector< std::thread >::iterator thread = pool.begin(); thread != pool.end(); ++thread ) {
+    thread->join();
+  }
+}
+
+template< typename T > void transposeInPlace(const unsigned int M, const unsigned int N, const unsigned int padding, std::vector< T > & data, const unsigned int tile) {
+  const std::size_t inputStride = isa::utils::pad(N, padding);
+  const std::size_t outputStride = isa::utils::pad(M, padding);
+
+  if ( M == N ) {
+    // Blocked swap of the tiles above the diagonal with the ones below it
+    for ( unsigned int baseM = 0; baseM < M; baseM += tile ) {
+      for ( unsigned int baseN = baseM; baseN < N; baseN += tile ) {
+        const unsigned int endM = std::min(baseM + tile, M);
+        const unsigned int endN = std::min(baseN + tile, N);
+
+        for ( unsigned int i = baseM; i < endM; i++ ) {
+          for ( unsigned int j = (baseM == baseN) ? i + 1 : baseN; j < endN; j++ ) {
+            std::swap(data[(i * inputStride) + j], data[(j * outputStride) + i]);
+          }
+        }
+      }
+    }
+  } else {
+    // Follow every chain moving each element to its destination
+    std::vector< unsigned int > leaders = getTransposeInPlaceLeaders(M, N, padding);
+
+    for ( std::vector< unsigned int >::const_iterator leader = leaders.begin(); leader != leaders.end(); ++leader ) {
+      std::size_t item = ((*leader % inputStride) * outputStride) + (*leader / inputStride);
+      T temp = data[*leader];
+
+      while ( (item < (M * inputStride)) && ((item % inputStride) < N) && (item != *leader) ) {
+        std::swap(temp, data[item]);
+        item = ((item % inputStride) * outputStride) + (item / inputStride);
+      }
+      data[item] = temp;
+    }
+  }
+}
+
 } // OpenCl
 } // isa
 
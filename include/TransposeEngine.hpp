@@ -0,0 +1,116 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+#include <InitializeOpenCL.hpp>
+#include <utils.hpp>
+#include <Transpose.hpp>
+#include <KernelCache.hpp>
+
+
+#ifndef TRANSPOSE_ENGINE_HPP
+#define TRANSPOSE_ENGINE_HPP
+
+namespace isa {
+namespace OpenCL {
+
+// Long lived host to host transpose: the OpenCL context, the queues, the compiled kernels and the device buffers are reused across requests
+class transposeEngine {
+public:
+  // nrQueues queues on device clDeviceID of platform clPlatformID; vector is the SIMD width of the device, an empty cacheDirectory keeps programs in memory only
+  transposeEngine(const unsigned int clPlatformID, const unsigned int clDeviceID, const unsigned int nrQueues, const unsigned int vector, const std::string & cacheDirectory);
+  // Waits for the transposes in flight
+  ~transposeEngine();
+
+  // Transpose the M x pad(N, padding) input into the N x pad(M, padding) output, the padding of the output is not touched; requests go round-robin over the queues.
+  // The input and output must stay valid until the future is ready, and the future must be kept to have more than one transpose in flight.
+  std::future< void > submit(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const std::string & typeName, const std::size_t typeSize, const void * input, void * output);
+  template< typename T > std::future< void > submit(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const std::string & typeName, const std::vector< T > & input, std::vector< T > & output);
+  // Get
+  cl::Context & getContext();
+  unsigned int getNrKernels() const;
+  // Device memory held by the buffer pool, in bytes
+  std::size_t getPoolSize() const;
+  kernelCache & getCache();
+
+private:
+  cl::Context clContext;
+  std::vector< cl::Platform > clPlatforms;
+  std::vector< cl::Device > clDevices;
+  std::vector< std::vector< cl::CommandQueue > > clQueues;
+  unsigned int clDeviceID;
+  unsigned int vector;
+  unsigned int nextQueue;
+  kernelCache cache;
+  // Configuration -> kernel
+  std::map< std::string, cl::Kernel * > kernels;
+  // Buffers not in use, by size; sizes are rounded up to a power of two so that similar requests share buffers
+  std::map< std::size_t, std::vector< cl::Buffer > > pool;
+  std::size_t poolSize;
+  unsigned int nrInFlight;
+  // submitMutex serializes the enqueueing, poolMutex protects the pool and nrInFlight
+  std::mutex submitMutex;
+  mutable std::mutex poolMutex;
+  std::condition_variable idle;
+
+  // A transpose in flight, completed by the OpenCL runtime when its output has been read
+  struct request {
+    transposeEngine * engine;
+    std::promise< void > done;
+    cl::Buffer input_d;
+    cl::Buffer output_d;
+    std::size_t inputSize;
+    std::size_t outputSize;
+  };
+
+  // Event callback: gives the buffers back to the pool and makes the future ready, without a host thread waiting for it
+  static void CL_CALLBACK completeRequest(cl_event event, cl_int status, void * data);
+  cl::Kernel * getKernel(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const std::string & typeName);
+  cl::Buffer acquireBuffer(const std::size_t size);
+  void releaseBuffer(const std::size_t size, const cl::Buffer & buffer);
+};
+
+// Smallest power of two not smaller than size, at least 4 KB
+std::size_t getPoolBucket(const std::size_t size);
+
+
+// Implementations
+
+template< typename T > std::future< void > transposeEngine::submit(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const std::string & typeName, const std::vector< T > & input, std::vector< T > & output) {
+  return submit(conf, M, N, padding, typeName, sizeof(T), reinterpret_cast< const void * >(input.data()), reinterpret_cast< void * >(output.data()));
+}
+
+inline cl::Context & transposeEngine::getContext() {
+  return clContext;
+}
+
+inline unsigned int transposeEngine::getNrKernels() const {
+  return kernels.size();
+}
+
+inline kernelCache & transposeEngine::getCache() {
+  return cache;
+}
+
+} // OpenCL
+} // isa
+
+#endif // TRANSPOSE_ENGINE_HPP
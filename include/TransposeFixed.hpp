@@ -0,0 +1,213 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+
+#include <utils.hpp>
+#include <Transpose.hpp>
+#include <TransposeSIMD.hpp>
+
+
+#ifndef TRANSPOSE_FIXED_HPP
+#define TRANSPOSE_FIXED_HPP
+
+namespace isa {
+namespace OpenCL {
+
+// Host transpose with the shape as template parameters, so that bounds and strides are constants as in the generated OpenCL kernels
+template< typename T > struct fixedTranspose {
+  unsigned int M;
+  unsigned int N;
+  unsigned int padding;
+  unsigned int tile;
+  void (* function)(const T * input, T * output, unsigned int nrThreads);
+};
+
+// Same result as isa::utils::pad(), usable in constant expressions
+constexpr unsigned int padFixed(const unsigned int value, const unsigned int padding) {
+  return (padding == 0) ? value : ((value + padding - 1) / padding) * padding;
+}
+// Side of the register tiles of simd for elements of typeSize bytes, 0 if there are none
+constexpr unsigned int getFixedRegisterTile(const hostSIMD simd, const std::size_t typeSize) {
+  return (typeSize == 4) ? ((simd == SIMD_AVX512) ? 16 : ((simd == SIMD_AVX2) ? 8 : ((simd == SIMD_SSE) ? 4 : 0))) : ((typeSize == 8) ? ((simd == SIMD_AVX512) ? 8 : ((simd == SIMD_AVX2) ? 4 : ((simd == SIMD_SSE) ? 2 : 0))) : 0);
+}
+// Transpose of a full tile x tile block, everything known at compile time; the block is made of register tiles of simd, inlined, when they divide tile.
+// There is a specialization for every instruction set, compiled for it, so that the register tiles can be inlined.
+template< hostSIMD simd > struct fixedTile {
+  template< typename T, unsigned int tile, std::size_t inputStride, std::size_t outputStride > static void transpose(const T * input, T * output);
+};
+// Transpose of the M x pad(N, padding) input into the N x pad(M, padding) output with tile x tile blocks, using the best instruction set of the host (nrThreads = 0 uses all hardware threads)
+template< typename T, unsigned int M, unsigned int N, unsigned int padding, unsigned int tile > void transposeFixed(const T * input, T * output, unsigned int nrThreads);
+template< hostSIMD simd, typename T, unsigned int M, unsigned int N, unsigned int padding, unsigned int tile > void transposeFixedSIMD(const T * input, T * output, unsigned int nrThreads);
+// Shapes instantiated for T; add a line to the table to specialize another shape
+template< typename T > const std::vector< fixedTranspose< T > > & getFixedTransposes();
+// Specialization for the shape, 0 if there is none
+template< typename T > const fixedTranspose< T > * findFixedTranspose(const unsigned int M, const unsigned int N, const unsigned int padding);
+// Transpose with the specialization for the shape if there is one, with the generic tiled transpose otherwise; returns true if specialized.
+// The specializations use the tile of their table entry, tile is only used by the generic transpose.
+template< typename T > bool transposeDispatch(const unsigned int M, const unsigned int N, const unsigned int padding, std::vector< T > & input, std::vector< T > & output, const unsigned int tile, unsigned int nrThreads);
+
+
+// Implementations
+
+template< typename T, unsigned int tile, std::size_t inputStride, std::size_t outputStride > inline void transposeFixedScalarTile(const T * input, T * output) {
+  for ( unsigned int i = 0; i < tile; i++ ) {
+    for ( unsigned int j = 0; j < tile; j++ ) {
+      output[(j * outputStride) + i] = input[(i * inputStride) + j];
+    }
+  }
+}
+
+template< hostSIMD simd > template< typename T, unsigned int tile, std::size_t inputStride, std::size_t outputStride > inline void fixedTile< simd >::transpose(const T * input, T * output) {
+  transposeFixedScalarTile< T, tile, inputStride, outputStride >(input, output);
+}
+
+#ifdef TRANSPOSE_X86
+// The register tiles work on the bits of float and double, any other type of the same size can use them
+#define TRANSPOSE_FIXED_TILE(simd, instructionSet, kernel32, kernel64) \
+template< > struct fixedTile< simd > { \
+  template< typename T, unsigned int tile, std::size_t inputStride, std::size_t outputStride > __attribute__((target(instructionSet))) static void transpose(const T * input, T * output) { \
+    constexpr unsigned int registerTile = getFixedRegisterTile(simd, sizeof(T)); \
+    if ( ! std::is_trivially_copyable< T >::value || (registerTile == 0) || ((tile % (registerTile + (registerTile == 0))) != 0) ) { \
+      transposeFixedScalarTile< T, tile, inputStride, outputStride >(input, output); \
+      return; \
+    } \
+    for ( unsigned int i = 0; i < tile; i += registerTile ) { \
+      for ( unsigned int j = 0; j < tile; j += registerTile ) { \
+        if ( sizeof(T) == 4 ) { \
+          kernel32(input + (i * inputStride) + j, inputStride, output + (j * outputStride) + i, outputStride); \
+        } else { \
+          kernel64(input + (i * inputStride) + j, inputStride, output + (j * outputStride) + i, outputStride); \
+        } \
+      } \
+    } \
+  } \
+};
+
+TRANSPOSE_FIXED_TILE(SIMD_SSE, "sse2", transposeTile4x4SSE, transposeTile2x2SSE)
+TRANSPOSE_FIXED_TILE(SIMD_AVX2, "avx2", transposeTile8x8AVX2, transposeTile4x4AVX2)
+TRANSPOSE_FIXED_TILE(SIMD_AVX512, "avx512f", transposeTile16x16AVX512, transposeTile8x8AVX512)
+#undef TRANSPOSE_FIXED_TILE
+#endif // TRANSPOSE_X86
+
+template< typename T, unsigned int M, unsigned int N, unsigned int padding, unsigned int tile > void transposeFixed(const T * input, T * output, unsigned int nrThreads) {
+  // One instantiation per instruction set, chosen once per call
+  switch ( getHostSIMD() ) {
+#ifdef TRANSPOSE_X86
+    case SIMD_AVX512:
+      transposeFixedSIMD< SIMD_AVX512, T, M, N, padding, tile >(input, output, nrThreads);
+      break;
+    case SIMD_AVX2:
+      transposeFixedSIMD< SIMD_AVX2, T, M, N, padding, tile >(input, output, nrThreads);
+      break;
+    case SIMD_SSE:
+      transposeFixedSIMD< SIMD_SSE, T, M, N, padding, tile >(input, output, nrThreads);
+      break;
+#endif
+    default:
+      transposeFixedSIMD< SIMD_NONE, T, M, N, padding, tile >(input, output, nrThreads);
+      break;
+  }
+}
+
+template< hostSIMD simd, typename T, unsigned int M, unsigned int N, unsigned int padding, unsigned int tile > void transposeFixedSIMD(const T * input, T * output, unsigned int nrThreads) {
+  static_assert(tile > 0, "The tile can not be empty.");
+  constexpr std::size_t inputStride = padFixed(N, padding);
+  constexpr std::size_t outputStride = padFixed(M, padding);
+  constexpr unsigned int nrTilesM = (M + tile - 1) / tile;
+  constexpr unsigned int nrTilesN = (N + tile - 1) / tile;
+  std::atomic< unsigned int > nextTile(0);
+  std::vector< std::thread > pool;
+
+  if ( nrThreads == 0 ) {
+    nrThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  nrThreads = std::min(nrThreads, nrTilesM * nrTilesN);
+
+  auto worker = [&]() {
+    for ( unsigned int tileID = nextTile++; tileID < nrTilesM * nrTilesN; tileID = nextTile++ ) {
+      const unsigned int baseM = (tileID / nrTilesN) * tile;
+      const unsigned int baseN = (tileID % nrTilesN) * tile;
+
+      if ( (baseM + tile <= M) && (baseN + tile <= N) ) {
+        fixedTile< simd >::template transpose< T, tile, inputStride, outputStride >(input + (baseM * inputStride) + baseN, output + (baseN * outputStride) + baseM);
+      } else {
+        // Only the last row and column of tiles can be partial, and only if tile does not divide the shape
+        const unsigned int endM = std::min(baseM + tile, M);
+        const unsigned int endN = std::min(baseN + tile, N);
+
+        for ( unsigned int i = baseM; i < endM; i++ ) {
+          for ( unsigned int j = baseN; j < endN; j++ ) {
+            output[(j * outputStride) + i] = input[(i * inputStride) + j];
+          }
+        }
+      }
+    }
+  };
+
+  for ( unsigned int thread = 1; thread < nrThreads; thread++ ) {
+    pool.push_back(std::thread(worker));
+  }
+  worker();
+  for ( std::vector< std::thread >::iterator thread = pool.begin(); thread != pool.end(); ++thread ) {
+    thread->join();
+  }
+}
+
+template< typename T > const std::vector< fixedTranspose< T > > & getFixedTransposes() {
+  static const std::vector< fixedTranspose< T > > table = {
+    {256, 256, 32, 64, &transposeFixed< T, 256, 256, 32, 64 >},
+    {512, 512, 32, 64, &transposeFixed< T, 512, 512, 32, 64 >},
+    {1024, 1024, 32, 64, &transposeFixed< T, 1024, 1024, 32, 64 >},
+    {2048, 2048, 32, 64, &transposeFixed< T, 2048, 2048, 32, 64 >},
+    {4096, 4096, 32, 64, &transposeFixed< T, 4096, 4096, 32, 64 >},
+    // Channels x samples of the radio astronomy pipelines
+    {1024, 16384, 32, 64, &transposeFixed< T, 1024, 16384, 32, 64 >},
+    {2048, 16384, 32, 64, &transposeFixed< T, 2048, 16384, 32, 64 >},
+    {16384, 1024, 32, 64, &transposeFixed< T, 16384, 1024, 32, 64 >}
+  };
+
+  return table;
+}
+
+template< typename T > const fixedTranspose< T > * findFixedTranspose(const unsigned int M, const unsigned int N, const unsigned int padding) {
+  const std::vector< fixedTranspose< T > > & table = getFixedTransposes< T >();
+
+  for ( typename std::vector< fixedTranspose< T > >::const_iterator shape = table.begin(); shape != table.end(); ++shape ) {
+    if ( (shape->M == M) && (shape->N == N) && (shape->padding == padding) ) {
+      return &(*shape);
+    }
+  }
+  return 0;
+}
+
+template< typename T > bool transposeDispatch(const unsigned int M, const unsigned int N, const unsigned int padding, std::vector< T > & input, std::vector< T > & output, const unsigned int tile, unsigned int nrThreads) {
+  const fixedTranspose< T > * fixed = findFixedTranspose< T >(M, N, padding);
+
+  if ( fixed == 0 ) {
+    transpose(M, N, padding, input, output, tile, nrThreads);
+    return false;
+  }
+  fixed->function(input.data(), output.data(), nrThreads);
+  return true;
+}
+
+} // OpenCL
+} // isa
+
+#endif // TRANSPOSE_FIXED_HPP
@@ -0,0 +1,85 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+#include <cstddef>
+
+#include <utils.hpp>
+
+
+#ifndef TRANSPOSE_PADDING_HPP
+#define TRANSPOSE_PADDING_HPP
+
+namespace isa {
+namespace OpenCL {
+
+// Rows a tile spans at most, the accesses of a tile to one column of the matrix
+const unsigned int paddingModelRows = 64;
+
+// Memory seen as nrBins bins of binSize bytes, interleaved, each holding associativity lines at the same time:
+// the sets of a cache, or the channels (partitions) of a device memory
+class paddingModel {
+public:
+  paddingModel(const unsigned int binSize, const unsigned int nrBins, const unsigned int associativity);
+  ~paddingModel();
+
+  // Get
+  unsigned int getBinSize() const;
+  unsigned int getNrBins() const;
+  unsigned int getAssociativity() const;
+  // Bytes after which addresses map to the same bin again
+  std::size_t getPeriod() const;
+  // Most of the first nrRows rows, stride bytes apart, that map to the same bin, in multiples of the associativity; 1 is conflict free
+  unsigned int getConflictDegree(const std::size_t stride, const unsigned int nrRows) const;
+
+private:
+  unsigned int binSize;
+  unsigned int nrBins;
+  unsigned int associativity;
+};
+
+// L1 data cache of the host, from sysconf() when available
+paddingModel getHostPaddingModel();
+// Memory channels of a device, 8 partitions of 256 bytes unless told otherwise; OpenCL can not query them
+paddingModel getDevicePaddingModel(const unsigned int partitionSize = 256, const unsigned int nrPartitions = 8);
+// Leading dimension for rows of columns elements of typeSize bytes: the smallest multiple of alignment, not smaller than columns, with the fewest conflicts
+unsigned int getAdvisedLeadingDimension(const unsigned int columns, const std::size_t typeSize, const unsigned int alignment, const paddingModel & model);
+// Up to nrCandidates values for the padding argument of the M x N transpose, multiples of alignment, best first; the input rows are pad(N, padding), the output rows pad(M, padding)
+std::vector< unsigned int > getPaddingCandidates(const unsigned int M, const unsigned int N, const std::size_t typeSize, const unsigned int alignment, const unsigned int nrCandidates, const paddingModel & model);
+// Best padding for the M x N transpose, to size the buffers before they are filled
+unsigned int getAdvisedPadding(const unsigned int M, const unsigned int N, const std::size_t typeSize, const unsigned int alignment, const paddingModel & model);
+
+
+// Implementations
+
+inline unsigned int paddingModel::getBinSize() const {
+  return binSize;
+}
+
+inline unsigned int paddingModel::getNrBins() const {
+  return nrBins;
+}
+
+inline unsigned int paddingModel::getAssociativity() const {
+  return associativity;
+}
+
+inline std::size_t paddingModel::getPeriod() const {
+  return static_cast< std::size_t >(binSize) * nrBins;
+}
+
+} // OpenCL
+} // isa
+
+#endif // TRANSPOSE_PADDING_HPP
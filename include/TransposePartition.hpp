@@ -0,0 +1,81 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+#include <cstddef>
+
+#include <InitializeOpenCL.hpp>
+#include <utils.hpp>
+#include <Transpose.hpp>
+
+
+#ifndef TRANSPOSE_PARTITION_HPP
+#define TRANSPOSE_PARTITION_HPP
+
+namespace isa {
+namespace OpenCL {
+
+// Host to host transpose of a M x pad(N) matrix split by rows over several devices of the same context; every partition has its own device buffers,
+// kernel and configuration, and writes its columns of the output directly
+class transposePartition {
+public:
+  // One partition per queue, partition i gets a share of the rows proportional to weights[i];
+  // throws std::invalid_argument without queues, without one weight per queue, or if no weight is positive
+  transposePartition(cl::Context & clContext, std::vector< cl::CommandQueue > & clQueues, const unsigned int M, const unsigned int N, const unsigned int padding, const std::size_t typeSize, const std::vector< double > & weights);
+  ~transposePartition();
+
+  // The kernel transposes the rows of the partition, e.g. from getTransposeOpenCL(conf, getNrRows(partition), N, padding, ...); the partition takes ownership
+  void setKernel(const unsigned int partition, const transposeConf & conf, cl::Kernel * kernel);
+  // All partitions run concurrently; returns when the output is complete
+  void run(const void * input, void * output);
+  // Get
+  unsigned int getNrPartitions() const;
+  unsigned int getFirstRow(const unsigned int partition) const;
+  unsigned int getNrRows(const unsigned int partition) const;
+
+private:
+  std::vector< cl::CommandQueue > & clQueues;
+  unsigned int M;
+  unsigned int N;
+  unsigned int padding;
+  std::size_t typeSize;
+  std::vector< unsigned int > firstRows;
+  std::vector< transposeConf > confs;
+  std::vector< cl::Kernel * > kernels;
+  std::vector< cl::Buffer > input_d;
+  std::vector< cl::Buffer > output_d;
+};
+
+// Sub-devices of clDevice, one per NUMA node; empty if the device can not be partitioned
+std::vector< cl::Device > getNUMASubDevices(cl::Device & clDevice);
+
+
+// Implementations
+
+inline unsigned int transposePartition::getNrPartitions() const {
+  return clQueues.size();
+}
+
+inline unsigned int transposePartition::getFirstRow(const unsigned int partition) const {
+  return firstRows[partition];
+}
+
+inline unsigned int transposePartition::getNrRows(const unsigned int partition) const {
+  return firstRows[partition + 1] - firstRows[partition];
+}
+
+} // OpenCL
+} // isa
+
+#endif // TRANSPOSE_PARTITION_HPP
@@ -0,0 +1,68 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+#include <cstddef>
+
+#include <InitializeOpenCL.hpp>
+#include <utils.hpp>
+#include <Transpose.hpp>
+
+
+#ifndef TRANSPOSE_PIPELINE_HPP
+#define TRANSPOSE_PIPELINE_HPP
+
+namespace isa {
+namespace OpenCL {
+
+// Host to host transpose of a M x pad(N) matrix in panels of rows; every queue owns a pair of device buffers and panels go round-robin over the queues,
+// so the upload of a panel, the transpose of the previous one and the download of the one before overlap
+class transposePipeline {
+public:
+  // Throws std::invalid_argument without queues; with one queue the panels run one after the other, at least two are needed to overlap transfers and compute
+  transposePipeline(cl::Context & clContext, std::vector< cl::CommandQueue > & clQueues, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int panelRows, const std::size_t typeSize);
+  ~transposePipeline();
+
+  // The kernel transposes a panel, e.g. from getTransposeOpenCL(conf, getPanelRows(), N, padding, ...); returns when the output is complete
+  void run(cl::Kernel & kernel, const transposeConf & conf, const void * input, void * output);
+  // Get
+  unsigned int getPanelRows() const;
+  unsigned int getNrPanels() const;
+
+private:
+  std::vector< cl::CommandQueue > & clQueues;
+  unsigned int M;
+  unsigned int N;
+  unsigned int padding;
+  unsigned int panelRows;
+  std::size_t typeSize;
+  std::vector< cl::Buffer > input_d;
+  std::vector< cl::Buffer > output_d;
+};
+
+
+// Implementations
+
+inline unsigned int transposePipeline::getPanelRows() const {
+  return panelRows;
+}
+
+inline unsigned int transposePipeline::getNrPanels() const {
+  return (M + panelRows - 1) / panelRows;
+}
+
+} // OpenCL
+} // isa
+
+#endif // TRANSPOSE_PIPELINE_HPP
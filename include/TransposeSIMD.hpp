@@ -0,0 +1,177 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TRANSPOSE_X86
+#endif
+
+
+#ifndef TRANSPOSE_SIMD_HPP
+#define TRANSPOSE_SIMD_HPP
+
+namespace isa {
+namespace OpenCL {
+
+#ifdef TRANSPOSE_X86
+// Register tiles of float (4 bytes) and double (8 bytes); strides are in elements.
+// They are always inlined, so that callers compiled for the same instruction set with constant strides get them folded in,
+// and getTransposeTileKernel() hands out their addresses for the callers with strides known only at run time.
+#if defined(__GNUC__) && ! defined(__clang__)
+// _mm512_undefined_*() in the intrinsics headers of some GCC releases triggers this warning
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+__attribute__((target("sse2"), always_inline)) inline void transposeTile4x4SSE(const void * input, const std::size_t inputStride, void * output, const std::size_t outputStride) {
+  const float * in = reinterpret_cast< const float * >(input);
+  float * out = reinterpret_cast< float * >(output);
+  __m128 row0 = _mm_loadu_ps(in);
+  __m128 row1 = _mm_loadu_ps(in + inputStride);
+  __m128 row2 = _mm_loadu_ps(in + (2 * inputStride));
+  __m128 row3 = _mm_loadu_ps(in + (3 * inputStride));
+
+  _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+  _mm_storeu_ps(out, row0);
+  _mm_storeu_ps(out + outputStride, row1);
+  _mm_storeu_ps(out + (2 * outputStride), row2);
+  _mm_storeu_ps(out + (3 * outputStride), row3);
+}
+
+__attribute__((target("sse2"), always_inline)) inline void transposeTile2x2SSE(const void * input, const std::size_t inputStride, void * output, const std::size_t outputStride) {
+  const double * in = reinterpret_cast< const double * >(input);
+  double * out = reinterpret_cast< double * >(output);
+  __m128d row0 = _mm_loadu_pd(in);
+  __m128d row1 = _mm_loadu_pd(in + inputStride);
+
+  _mm_storeu_pd(out, _mm_unpacklo_pd(row0, row1));
+  _mm_storeu_pd(out + outputStride, _mm_unpackhi_pd(row0, row1));
+}
+
+__attribute__((target("avx2"), always_inline)) inline void transposeTile8x8AVX2(const void * input, const std::size_t inputStride, void * output, const std::size_t outputStride) {
+  const float * in = reinterpret_cast< const float * >(input);
+  float * out = reinterpret_cast< float * >(output);
+  __m256 rows[8];
+  __m256 temp[8];
+
+  for ( unsigned int row = 0; row < 8; row++ ) {
+    rows[row] = _mm256_loadu_ps(in + (row * inputStride));
+  }
+  // Interleave pairs of rows, then pairs of pairs, inside each 128 bit lane
+  for ( unsigned int row = 0; row < 8; row += 2 ) {
+    temp[row] = _mm256_unpacklo_ps(rows[row], rows[row + 1]);
+    temp[row + 1] = _mm256_unpackhi_ps(rows[row], rows[row + 1]);
+  }
+  for ( unsigned int row = 0; row < 8; row += 4 ) {
+    rows[row] = _mm256_shuffle_ps(temp[row], temp[row + 2], _MM_SHUFFLE(1, 0, 1, 0));
+    rows[row + 1] = _mm256_shuffle_ps(temp[row], temp[row + 2], _MM_SHUFFLE(3, 2, 3, 2));
+    rows[row + 2] = _mm256_shuffle_ps(temp[row + 1], temp[row + 3], _MM_SHUFFLE(1, 0, 1, 0));
+    rows[row + 3] = _mm256_shuffle_ps(temp[row + 1], temp[row + 3], _MM_SHUFFLE(3, 2, 3, 2));
+  }
+  // Exchange the 128 bit lanes
+  for ( unsigned int row = 0; row < 4; row++ ) {
+    _mm256_storeu_ps(out + (row * outputStride), _mm256_permute2f128_ps(rows[row], rows[row + 4], 0x20));
+    _mm256_storeu_ps(out + ((row + 4) * outputStride), _mm256_permute2f128_ps(rows[row], rows[row + 4], 0x31));
+  }
+}
+
+__attribute__((target("avx2"), always_inline)) inline void transposeTile4x4AVX2(const void * input, const std::size_t inputStride, void * output, const std::size_t outputStride) {
+  const double * in = reinterpret_cast< const double * >(input);
+  double * out = reinterpret_cast< double * >(output);
+  __m256d row0 = _mm256_loadu_pd(in);
+  __m256d row1 = _mm256_loadu_pd(in + inputStride);
+  __m256d row2 = _mm256_loadu_pd(in + (2 * inputStride));
+  __m256d row3 = _mm256_loadu_pd(in + (3 * inputStride));
+  __m256d temp0 = _mm256_unpacklo_pd(row0, row1);
+  __m256d temp1 = _mm256_unpackhi_pd(row0, row1);
+  __m256d temp2 = _mm256_unpacklo_pd(row2, row3);
+  __m256d temp3 = _mm256_unpackhi_pd(row2, row3);
+
+  _mm256_storeu_pd(out, _mm256_permute2f128_pd(temp0, temp2, 0x20));
+  _mm256_storeu_pd(out + outputStride, _mm256_permute2f128_pd(temp1, temp3, 0x20));
+  _mm256_storeu_pd(out + (2 * outputStride), _mm256_permute2f128_pd(temp0, temp2, 0x31));
+  _mm256_storeu_pd(out + (3 * outputStride), _mm256_permute2f128_pd(temp1, temp3, 0x31));
+}
+
+__attribute__((target("avx512f"), always_inline)) inline void transposeTile16x16AVX512(const void * input, const std::size_t inputStride, void * output, const std::size_t outputStride) {
+  const float * in = reinterpret_cast< const float * >(input);
+  float * out = reinterpret_cast< float * >(output);
+  __m512 rows[16];
+  __m512 temp[16];
+
+  for ( unsigned int row = 0; row < 16; row++ ) {
+    rows[row] = _mm512_loadu_ps(in + (row * inputStride));
+  }
+  // 4x4 transposes inside each 128 bit lane
+  for ( unsigned int row = 0; row < 16; row += 2 ) {
+    temp[row] = _mm512_unpacklo_ps(rows[row], rows[row + 1]);
+    temp[row + 1] = _mm512_unpackhi_ps(rows[row], rows[row + 1]);
+  }
+  for ( unsigned int row = 0; row < 16; row += 4 ) {
+    rows[row] = _mm512_castpd_ps(_mm512_unpacklo_pd(_mm512_castps_pd(temp[row]), _mm512_castps_pd(temp[row + 2])));
+    rows[row + 1] = _mm512_castpd_ps(_mm512_unpackhi_pd(_mm512_castps_pd(temp[row]), _mm512_castps_pd(temp[row + 2])));
+    rows[row + 2] = _mm512_castpd_ps(_mm512_unpacklo_pd(_mm512_castps_pd(temp[row + 1]), _mm512_castps_pd(temp[row + 3])));
+    rows[row + 3] = _mm512_castpd_ps(_mm512_unpackhi_pd(_mm512_castps_pd(temp[row + 1]), _mm512_castps_pd(temp[row + 3])));
+  }
+  // 4x4 transpose of the 128 bit lanes
+  for ( unsigned int column = 0; column < 4; column++ ) {
+    temp[column] = _mm512_shuffle_f32x4(rows[column], rows[column + 4], 0x88);
+    temp[column + 4] = _mm512_shuffle_f32x4(rows[column], rows[column + 4], 0xdd);
+    temp[column + 8] = _mm512_shuffle_f32x4(rows[column + 8], rows[column + 12], 0x88);
+    temp[column + 12] = _mm512_shuffle_f32x4(rows[column + 8], rows[column + 12], 0xdd);
+  }
+  for ( unsigned int column = 0; column < 4; column++ ) {
+    _mm512_storeu_ps(out + (column * outputStride), _mm512_shuffle_f32x4(temp[column], temp[column + 8], 0x88));
+    _mm512_storeu_ps(out + ((column + 8) * outputStride), _mm512_shuffle_f32x4(temp[column], temp[column + 8], 0xdd));
+    _mm512_storeu_ps(out + ((column + 4) * outputStride), _mm512_shuffle_f32x4(temp[column + 4], temp[column + 12], 0x88));
+    _mm512_storeu_ps(out + ((column + 12) * outputStride), _mm512_shuffle_f32x4(temp[column + 4], temp[column + 12], 0xdd));
+  }
+}
+
+__attribute__((target("avx512f"), always_inline)) inline void transposeTile8x8AVX512(const void * input, const std::size_t inputStride, void * output, const std::size_t outputStride) {
+  const double * in = reinterpret_cast< const double * >(input);
+  double * out = reinterpret_cast< double * >(output);
+  __m512d rows[8];
+  __m512d temp[8];
+
+  for ( unsigned int row = 0; row < 8; row++ ) {
+    rows[row] = _mm512_loadu_pd(in + (row * inputStride));
+  }
+  // 2x2 transposes inside each 128 bit lane
+  for ( unsigned int row = 0; row < 8; row += 2 ) {
+    temp[row] = _mm512_unpacklo_pd(rows[row], rows[row + 1]);
+    temp[row + 1] = _mm512_unpackhi_pd(rows[row], rows[row + 1]);
+  }
+  // 4x4 transpose of the 128 bit lanes
+  for ( unsigned int row = 0; row < 8; row += 4 ) {
+    rows[row] = _mm512_shuffle_f64x2(temp[row], temp[row + 2], 0x88);
+    rows[row + 1] = _mm512_shuffle_f64x2(temp[row + 1], temp[row + 3], 0x88);
+    rows[row + 2] = _mm512_shuffle_f64x2(temp[row], temp[row + 2], 0xdd);
+    rows[row + 3] = _mm512_shuffle_f64x2(temp[row + 1], temp[row + 3], 0xdd);
+  }
+  for ( unsigned int column = 0; column < 4; column++ ) {
+    _mm512_storeu_pd(out + (column * outputStride), _mm512_shuffle_f64x2(rows[column], rows[column + 4], 0x88));
+    _mm512_storeu_pd(out + ((column + 4) * outputStride), _mm512_shuffle_f64x2(rows[column], rows[column + 4], 0xdd));
+  }
+}
+#if defined(__GNUC__) && ! defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif // TRANSPOSE_X86
+
+} // OpenCL
+} // isa
+
+#endif // TRANSPOSE_SIMD_HPP
@@ -0,0 +1,112 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+#include <random>
+#include <chrono>
+
+#include <Transpose.hpp>
+
+
+#ifndef TRANSPOSE_SEARCH_HPP
+#define TRANSPOSE_SEARCH_HPP
+
+namespace isa {
+namespace OpenCL {
+
+// Order in which the tuner tries the configurations; configurations are identified by their index
+class transposeSearch {
+public:
+  transposeSearch(const std::vector< transposeConf > & configurations);
+  virtual ~transposeSearch();
+
+  // Next configuration to try, false when the search is over
+  virtual bool next(unsigned int & configuration) = 0;
+  // Configurations likely to be tried soon, at most nrConfigurations
+  virtual std::vector< unsigned int > lookahead(const unsigned int nrConfigurations) const = 0;
+  // Throughput measured for a configuration, 0 if it failed or was stopped early
+  virtual void update(const unsigned int configuration, const double gbs);
+  // Best configuration so far
+  double getBestGBs() const;
+  unsigned int getBest() const;
+
+protected:
+  const std::vector< transposeConf > & configurations;
+  double bestGBs;
+  unsigned int best;
+};
+
+// All configurations, in order
+class exhaustiveSearch : public transposeSearch {
+public:
+  exhaustiveSearch(const std::vector< transposeConf > & configurations);
+  ~exhaustiveSearch();
+
+  bool next(unsigned int & configuration);
+  std::vector< unsigned int > lookahead(const unsigned int nrConfigurations) const;
+
+protected:
+  std::vector< unsigned int > order;
+  unsigned int position;
+};
+
+// nrSamples configurations drawn without replacement
+class randomSearch : public exhaustiveSearch {
+public:
+  randomSearch(const std::vector< transposeConf > & configurations, const unsigned int nrSamples, const unsigned int seed);
+  ~randomSearch();
+};
+
+// Simulated annealing, moving to configurations that differ in a single parameter; the temperature goes to zero at the end of the time budget
+class annealingSearch : public transposeSearch {
+public:
+  // A budget of 0 seconds cools down over one step per configuration
+  annealingSearch(const std::vector< transposeConf > & configurations, const double budget, const unsigned int seed);
+  ~annealingSearch();
+
+  bool next(unsigned int & configuration);
+  std::vector< unsigned int > lookahead(const unsigned int nrConfigurations) const;
+  void update(const unsigned int configuration, const double gbs);
+
+private:
+  double budget;
+  std::chrono::steady_clock::time_point start;
+  unsigned int nrSteps;
+  std::vector< bool > visited;
+  unsigned int nrVisited;
+  unsigned int current;
+  double currentGBs;
+  // Neighbours of current not tried yet, in the order they are going to be tried
+  std::vector< unsigned int > candidates;
+  std::mt19937 generator;
+
+  double getTemperature() const;
+  void plan();
+};
+
+
+// Implementations
+
+inline double transposeSearch::getBestGBs() const {
+  return bestGBs;
+}
+
+inline unsigned int transposeSearch::getBest() const {
+  return best;
+}
+
+} // OpenCL
+} // isa
+
+#endif // TRANSPOSE_SEARCH_HPP
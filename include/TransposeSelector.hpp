@@ -0,0 +1,70 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <Transpose.hpp>
+
+
+#ifndef TRANSPOSE_SELECTOR_HPP
+#define TRANSPOSE_SELECTOR_HPP
+
+namespace isa {
+namespace OpenCL {
+
+// Best configuration found by the tuner for one shape
+struct tunedTransposeEntry {
+  unsigned int M;
+  unsigned int N;
+  unsigned int padding;
+  transposeConf conf;
+  double gbs;
+};
+
+// Tuned configurations indexed by device, type, M, N and padding
+class transposeSelector {
+public:
+  transposeSelector();
+  ~transposeSelector();
+
+  // Add a tuned configuration, replacing the one for the same key if slower
+  void insert(const std::string & deviceName, const std::string & typeName, const unsigned int M, const unsigned int N, const unsigned int padding, const transposeConf & conf, const double gbs);
+  // True if the shape has been tuned
+  bool contains(const std::string & deviceName, const std::string & typeName, const unsigned int M, const unsigned int N, const unsigned int padding) const;
+  // Configuration of the tuned shape closest to (M, N), in log scale, preferring the same padding; throws std::out_of_range if nothing was tuned for device and type
+  const transposeConf & select(const std::string & deviceName, const std::string & typeName, const unsigned int M, const unsigned int N, const unsigned int padding) const;
+  // Binary file, in host byte order; read merges the file with the configurations already known and throws std::runtime_error if the file is not valid
+  void read(const std::string & filename);
+  void write(const std::string & filename) const;
+  unsigned int getNrEntries() const;
+
+private:
+  // Device, type and the tuned shapes
+  std::map< std::string, std::map< std::string, std::vector< tunedTransposeEntry > > > entries;
+  unsigned int nrEntries;
+};
+
+
+// Implementations
+
+inline unsigned int transposeSelector::getNrEntries() const {
+  return nrEntries;
+}
+
+} // OpenCL
+} // isa
+
+#endif // TRANSPOSE_SELECTOR_HPP
@@ -0,0 +1,123 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <functional>
+#include <future>
+#include <cstddef>
+
+#include <utils.hpp>
+#include <Transpose.hpp>
+
+
+#ifndef TRANSPOSE_STREAM_HPP
+#define TRANSPOSE_STREAM_HPP
+
+namespace isa {
+namespace OpenCL {
+
+// Shared memory mapping of a whole file
+class mappedFile {
+public:
+  // The file is created, or resized, if writable
+  mappedFile(const std::string & filename, const std::size_t size, const bool writable);
+  ~mappedFile();
+
+  // Get
+  void * getData() const;
+  std::size_t getSize() const;
+  // Hint the kernel about the pages that are going to be used soon, or not at all
+  void willNeed(const std::size_t offset, const std::size_t size) const;
+  void dontNeed(const std::size_t offset, const std::size_t size) const;
+  // Force a range to be paged in
+  void touch(const std::size_t offset, const std::size_t size) const;
+  // Start writing back dirty pages
+  void flush() const;
+
+private:
+  int fileDescriptor;
+  void * data;
+  std::size_t size;
+};
+
+// Transpose rows [firstRow, firstRow + nrRows) of the input; panel points to firstRow, output to the whole output
+template< typename T > using panelTranspose = std::function< void(const unsigned int firstRow, const unsigned int nrRows, const T * panel, T * output) >;
+
+// Rows per panel that fit in memoryBudget bytes, rounded down to a multiple of rowMultiple; throws std::invalid_argument if rowMultiple is 0
+unsigned int getTransposePanelRows(const unsigned int M, const unsigned int N, const unsigned int padding, const std::size_t typeSize, const std::size_t memoryBudget, const unsigned int rowMultiple);
+// Out-of-core transpose of a M x pad(N) file into a N x pad(M) file, one panel of rows at a time
+template< typename T > void transposeFile(const std::string & inputFilename, const std::string & outputFilename, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int panelRows, panelTranspose< T > & kernel);
+// Panel transpose on the host, using the tiled or the recursive transpose
+template< typename T > panelTranspose< T > getHostPanelTranspose(const hostAlgorithm algorithm, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int tile, const unsigned int nrThreads);
+
+
+// Implementations
+
+inline void * mappedFile::getData() const {
+  return data;
+}
+
+inline std::size_t mappedFile::getSize() const {
+  return size;
+}
+
+template< typename T > void transposeFile(const std::string & inputFilename, const std::string & outputFilename, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int panelRows, panelTranspose< T > & kernel) {
+  const std::size_t panelSize = static_cast< std::size_t >(panelRows) * isa::utils::pad(N, padding) * sizeof(T);
+  mappedFile input(inputFilename, static_cast< std::size_t >(M) * isa::utils::pad(N, padding) * sizeof(T), false);
+  mappedFile output(outputFilename, static_cast< std::size_t >(N) * isa::utils::pad(M, padding) * sizeof(T), true);
+  const T * inputData = reinterpret_cast< const T * >(input.getData());
+  T * outputData = reinterpret_cast< T * >(output.getData());
+  std::future< void > prefetch;
+  std::future< void > writeBack;
+
+  input.willNeed(0, panelSize);
+  for ( unsigned int firstRow = 0; firstRow < M; firstRow += panelRows ) {
+    const unsigned int nrRows = std::min(panelRows, M - firstRow);
+    const std::size_t offset = static_cast< std::size_t >(firstRow) * isa::utils::pad(N, padding) * sizeof(T);
+
+    // Read the next panel while this one is transposed
+    if ( firstRow + panelRows < M ) {
+      prefetch = std::async(std::launch::async, [&input, offset, panelSize]() {
+        input.willNeed(offset + panelSize, panelSize);
+        input.touch(offset + panelSize, panelSize);
+      });
+    }
+    kernel(firstRow, nrRows, inputData + (static_cast< std::size_t >(firstRow) * isa::utils::pad(N, padding)), outputData);
+    if ( writeBack.valid() ) {
+      writeBack.wait();
+    }
+    // Write this panel back and release its input while the next one is transposed; every panel writes columns across the whole output, so no output page is finished before the last panel and the output is only flushed
+    writeBack = std::async(std::launch::async, [&input, &output, offset, panelSize]() {
+      output.flush();
+      input.dontNeed(offset, panelSize);
+    });
+    if ( prefetch.valid() ) {
+      prefetch.wait();
+    }
+  }
+  if ( writeBack.valid() ) {
+    writeBack.wait();
+  }
+}
+
+template< typename T > panelTranspose< T > getHostPanelTranspose(const hostAlgorithm algorithm, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int tile, const unsigned int nrThreads) {
+  return [algorithm, M, N, padding, tile, nrThreads](const unsigned int firstRow, const unsigned int nrRows, const T * panel, T * output) {
+    transposeHost(algorithm, nrRows, N, panel, isa::utils::pad(N, padding), output + firstRow, isa::utils::pad(M, padding), tile, nrThreads);
+  };
+}
+
+} // OpenCL
+} // isa
+
+#endif // TRANSPOSE_STREAM_HPP
@@ -0,0 +1,71 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+#include <complex>
+#include <ostream>
+#include <cstdint>
+
+
+#ifndef TRANSPOSE_TYPES_HPP
+#define TRANSPOSE_TYPES_HPP
+
+namespace isa {
+namespace OpenCL {
+
+// Host storage of an OpenCL half: the bits of the IEEE 754 number, as the transposes only move them
+struct halfType {
+  std::uint16_t bits;
+};
+// Host storage of an OpenCL float2, a complex sample
+typedef std::complex< float > complexType;
+
+bool operator==(const halfType & left, const halfType & right);
+bool operator!=(const halfType & left, const halfType & right);
+// Printed as its float value
+std::ostream & operator<<(std::ostream & stream, const halfType & value);
+// Conversions between half and float; they round to nearest even and keep infinities and NaNs
+halfType floatToHalf(const float value);
+float halfToFloat(const halfType value);
+
+// OpenCL names of the element types the harnesses can transpose
+const std::vector< std::string > & getTransposeTypeNames();
+// OpenCL name of T
+template< typename T > std::string getTransposeTypeName();
+// Random value of T with small integer components, so that it is exact in every type
+template< typename T > T getRandomTransposeValue();
+// Value of T that getRandomTransposeValue() never returns, to fill memory that must not be written
+template< typename T > T getTransposeFillValue();
+
+template< > std::string getTransposeTypeName< float >();
+template< > std::string getTransposeTypeName< double >();
+template< > std::string getTransposeTypeName< unsigned char >();
+template< > std::string getTransposeTypeName< halfType >();
+template< > std::string getTransposeTypeName< complexType >();
+template< > float getRandomTransposeValue< float >();
+template< > double getRandomTransposeValue< double >();
+template< > unsigned char getRandomTransposeValue< unsigned char >();
+template< > halfType getRandomTransposeValue< halfType >();
+template< > complexType getRandomTransposeValue< complexType >();
+template< > float getTransposeFillValue< float >();
+template< > double getTransposeFillValue< double >();
+template< > unsigned char getTransposeFillValue< unsigned char >();
+template< > halfType getTransposeFillValue< halfType >();
+template< > complexType getTransposeFillValue< complexType >();
+
+} // OpenCL
+} // isa
+
+#endif // TRANSPOSE_TYPES_HPP
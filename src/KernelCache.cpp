@@ -0,0 +1,189 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+
+#include <Timer.hpp>
+#include <KernelCache.hpp>
+
+namespace isa {
+namespace OpenCL {
+
+kernelCache::kernelCache(const std::string & directory) : directory(directory), nrHits(0), nrMisses(0), lastHit(false), lastTime(0.0) {}
+
+kernelCache::~kernelCache() {}
+
+std::string hashString(const std::string & text) {
+  uint64_t hash = 14695981039346656037ULL;
+  char hexHash[17];
+
+  for ( std::string::const_iterator item = text.begin(); item != text.end(); ++item ) {
+    hash ^= static_cast< unsigned char >(*item);
+    hash *= 1099511628211ULL;
+  }
+  std::snprintf(hexHash, 17, "%016llx", static_cast< unsigned long long >(hash));
+
+  return std::string(hexHash);
+}
+
+bool kernelCache::loadBinary(const std::string & key, std::vector< unsigned char > & binary) {
+  std::lock_guard< std::mutex > lock(cacheMutex);
+
+  if ( binaries.count(key) > 0 ) {
+    binary = binaries[key];
+    return true;
+  } else if ( directory.empty() ) {
+    return false;
+  }
+  std::ifstream binaryFile(directory + "/" + key + ".bin", std::ios::binary);
+
+  if ( ! binaryFile ) {
+    return false;
+  }
+  binary.assign(std::istreambuf_iterator< char >(binaryFile), std::istreambuf_iterator< char >());
+  binaries[key] = binary;
+
+  return binary.size() > 0;
+}
+
+void kernelCache::storeBinary(const std::string & key, const std::vector< unsigned char > & binary) {
+  std::lock_guard< std::mutex > lock(cacheMutex);
+
+  binaries[key] = binary;
+  if ( ! directory.empty() ) {
+    std::ofstream binaryFile(directory + "/" + key + ".bin", std::ios::binary);
+
+    binaryFile.write(reinterpret_cast< const char * >(binary.data()), binary.size());
+  }
+}
+
+void kernelCache::dropBinary(const std::string & key) {
+  std::lock_guard< std::mutex > lock(cacheMutex);
+
+  binaries.erase(key);
+  if ( ! directory.empty() ) {
+    std::remove((directory + "/" + key + ".bin").c_str());
+  }
+}
+
+cl::Kernel * kernelCache::getKernel(const std::string & name, const std::string & configuration, std::function< std::string * () > generator, const std::string & options, cl::Context & clContext, cl::Device & clDevice) {
+  const std::string deviceKey = clDevice.getInfo< CL_DEVICE_NAME >() + "\n" + clDevice.getInfo< CL_DRIVER_VERSION >() + "\n";
+  const std::string configurationKey = hashString(deviceKey + isa::utils::toString(kernelGeneratorVersion) + "\n" + name + "\n" + configuration + "\n" + options);
+  std::vector< cl::Device > devices(1, clDevice);
+  std::vector< unsigned char > binary;
+  std::string sourceHash;
+  cl::Program program;
+  isa::utils::Timer timer;
+  bool hit = false;
+
+  timer.start();
+  // Source hash of this configuration, from memory or disk
+  {
+    std::lock_guard< std::mutex > lock(cacheMutex);
+
+    if ( sources.count(configurationKey) > 0 ) {
+      sourceHash = sources[configurationKey];
+    } else if ( ! directory.empty() ) {
+      std::ifstream sourceFile(directory + "/" + configurationKey + ".source");
+
+      sourceFile >> sourceHash;
+    }
+  }
+  hit = ! sourceHash.empty() && loadBinary(hashString(deviceKey + sourceHash + "\n" + options), binary);
+  if ( hit ) {
+    try {
+      program = cl::Program(clContext, devices, cl::Program::Binaries(1, std::make_pair(binary.data(), binary.size())));
+      program.build(devices, options.c_str());
+    } catch ( cl::Error & err ) {
+      // Stale or corrupted binary, forget it also on disk and regenerate it
+      dropBinary(hashString(deviceKey + sourceHash + "\n" + options));
+      binary.clear();
+      hit = false;
+    }
+  }
+  if ( ! hit ) {
+    std::string * code = generator();
+    std::string binaryKey;
+
+    sourceHash = hashString(*code);
+    binaryKey = hashString(deviceKey + sourceHash + "\n" + options);
+    {
+      std::lock_guard< std::mutex > lock(cacheMutex);
+
+      sources[configurationKey] = sourceHash;
+      if ( ! directory.empty() ) {
+        std::ofstream sourceFile(directory + "/" + configurationKey + ".source");
+
+        sourceFile << sourceHash << std::endl;
+      }
+    }
+    if ( loadBinary(binaryKey, binary) ) {
+      // Another configuration generated the same source, but its binary may be as bad as the one above
+      try {
+        program = cl::Program(clContext, devices, cl::Program::Binaries(1, std::make_pair(binary.data(), binary.size())));
+        program.build(devices, options.c_str());
+      } catch ( cl::Error & err ) {
+        dropBinary(binaryKey);
+        binary.clear();
+      }
+    } else {
+      binary.clear();
+    }
+    try {
+      if ( binary.size() == 0 ) {
+        program = cl::Program(clContext, cl::Program::Sources(1, std::make_pair(code->c_str(), code->length())));
+        program.build(devices, options.c_str());
+      }
+    } catch ( cl::Error & err ) {
+      delete code;
+      throw isa::OpenCL::OpenCLError("It is not possible to build the " + name + " OpenCL program: " + program.getBuildInfo< CL_PROGRAM_BUILD_LOG >(clDevice) + ".");
+    }
+    delete code;
+    if ( binary.size() == 0 ) {
+      std::vector< std::size_t > sizes = program.getInfo< CL_PROGRAM_BINARY_SIZES >();
+      std::vector< char * > programBinaries(1, 0);
+
+      binary.resize(sizes.at(0));
+      programBinaries[0] = reinterpret_cast< char * >(binary.data());
+      program.getInfo(CL_PROGRAM_BINARIES, &programBinaries);
+      storeBinary(binaryKey, binary);
+    }
+  }
+
+  cl::Kernel * kernel = 0;
+  try {
+    kernel = new cl::Kernel(program, name.c_str(), 0);
+  } catch ( cl::Error & err ) {
+    throw isa::OpenCL::OpenCLError("It is not possible to create the " + name + " OpenCL kernel: " + isa::utils::toString(err.err()) + ".");
+  }
+  timer.stop();
+  {
+    std::lock_guard< std::mutex > lock(cacheMutex);
+
+    if ( hit ) {
+      nrHits++;
+    } else {
+      nrMisses++;
+    }
+    lastHit = hit;
+    lastTime = timer.getLastRunTime();
+  }
+
+  return kernel;
+}
+
+} // OpenCL
+} // isa
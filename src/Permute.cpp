@@ -0,0 +1,178 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdexcept>
+#include <sstream>
+#include <cmath>
+
+#include <Permute.hpp>
+
+namespace isa {
+namespace OpenCL {
+
+// Code computing inputOffset and outputOffset from the flattened index of all axes but the skipped ones
+static std::string getPermuteOffsets(const std::string & index, const std::vector< unsigned int > & shape, const std::vector< std::size_t > & inputStrides, const std::vector< std::size_t > & permutedStrides, const unsigned int inner, const unsigned int outer) {
+  std::string code = "unsigned int inputOffset = 0;\n"
+  "unsigned int outputOffset = 0;\n"
+  "unsigned int index = " + index + ";\n";
+
+  for ( int axis = shape.size() - 1; axis >= 0; axis-- ) {
+    if ( static_cast< unsigned int >(axis) == inner || static_cast< unsigned int >(axis) == outer ) {
+      continue;
+    }
+    code += "inputOffset += (index % " + isa::utils::toString(shape[axis]) + ") * " + isa::utils::toString(inputStrides[axis]) + ";\n"
+    "outputOffset += (index % " + isa::utils::toString(shape[axis]) + ") * " + isa::utils::toString(permutedStrides[axis]) + ";\n"
+    "index /= " + isa::utils::toString(shape[axis]) + ";\n";
+  }
+  return code;
+}
+
+std::vector< unsigned int > readPermuteAxes(const std::string & axes) {
+  std::vector< unsigned int > list;
+  std::istringstream stream(axes);
+  std::string axis;
+
+  while ( std::getline(stream, axis, ',') ) {
+    list.push_back(isa::utils::castToType< std::string, unsigned int >(axis));
+  }
+  return list;
+}
+
+std::vector< unsigned int > getPermuteShape(const std::vector< unsigned int > & shape, const std::vector< unsigned int > & permutation) {
+  std::vector< unsigned int > permutedShape(shape.size());
+  std::vector< bool > used(shape.size(), false);
+
+  if ( shape.size() == 0 || permutation.size() != shape.size() ) {
+    throw std::invalid_argument("The permutation must have one entry per axis.");
+  }
+  for ( unsigned int axis = 0; axis < permutation.size(); axis++ ) {
+    if ( permutation[axis] >= shape.size() || used[permutation[axis]] ) {
+      throw std::invalid_argument("The permutation must contain every axis exactly once.");
+    }
+    used[permutation[axis]] = true;
+    permutedShape[axis] = shape[permutation[axis]];
+  }
+  return permutedShape;
+}
+
+std::vector< std::size_t > getPermuteStrides(const std::vector< unsigned int > & shape, const std::vector< unsigned int > & padding) {
+  std::vector< std::size_t > strides(shape.size());
+  std::size_t stride = 1;
+
+  if ( shape.size() == 0 || padding.size() != shape.size() ) {
+    throw std::invalid_argument("The padding must have one entry per axis.");
+  }
+  for ( int axis = shape.size() - 1; axis >= 0; axis-- ) {
+    strides[axis] = stride;
+    stride *= isa::utils::pad(shape[axis], padding[axis]);
+  }
+  return strides;
+}
+
+std::vector< unsigned int > getPermutePadding(const unsigned int nrAxes, const unsigned int padding) {
+  std::vector< unsigned int > axisPadding(nrAxes, 1);
+
+  if ( nrAxes > 0 ) {
+    axisPadding[nrAxes - 1] = padding;
+  }
+  return axisPadding;
+}
+
+std::size_t getPermuteSize(const std::vector< unsigned int > & shape, const std::vector< unsigned int > & padding) {
+  return getPermuteStrides(shape, padding)[0] * isa::utils::pad(shape[0], padding[0]);
+}
+
+std::string * getPermuteOpenCL(const transposeConf & conf, const std::vector< unsigned int > & shape, const std::vector< unsigned int > & inputPadding, const std::vector< unsigned int > & permutation, const std::vector< unsigned int > & outputPadding, const unsigned int vector, std::string typeName) {
+  std::string * code = new std::string();
+  const unsigned int nrAxes = shape.size();
+  const std::vector< std::size_t > inputStrides = getPermuteStrides(shape, inputPadding);
+  const std::vector< std::size_t > outputStrides = getPermuteStrides(getPermuteShape(shape, permutation), outputPadding);
+  const unsigned int inner = nrAxes - 1;
+  const unsigned int outer = permutation[nrAxes - 1];
+  std::vector< std::size_t > permutedStrides(nrAxes);
+
+  for ( unsigned int axis = 0; axis < nrAxes; axis++ ) {
+    permutedStrides[permutation[axis]] = outputStrides[axis];
+  }
+  typeName = getTransposeStorageType(typeName);
+
+  // Begin kernel's template
+  *code = getTransposeExtensions(typeName, typeName)
+  + "__kernel void permute(__global const " + typeName + " * const restrict permuteInput, __global " + typeName + " * const restrict permuteOutput) {\n";
+  if ( inner == outer ) {
+    // The contiguous axis does not move: tiles of tileHeight rows by tileWidth elements are copied
+    unsigned int nrRows = 1;
+
+    for ( unsigned int axis = 0; axis < inner; axis++ ) {
+      nrRows *= shape[axis];
+    }
+    *code += "for ( unsigned int item = get_local_id(0); item < " + isa::utils::toString(conf.getTileWidth() * conf.getTileHeight()) + "; item += " + isa::utils::toString(conf.getNrThreads()) + " ) {\n"
+    "const unsigned int row = (get_group_id(0) * " + isa::utils::toString(conf.getTileHeight()) + ") + (item / " + isa::utils::toString(conf.getTileWidth()) + ");\n"
+    "const unsigned int n = (get_group_id(1) * " + isa::utils::toString(conf.getTileWidth()) + ") + (item % " + isa::utils::toString(conf.getTileWidth()) + ");\n"
+    "if ( (row >= " + isa::utils::toString(nrRows) + ") || (n >= " + isa::utils::toString(shape[inner]) + ") ) {\n"
+    "continue;\n"
+    "}\n"
+    + getPermuteOffsets("row", shape, inputStrides, permutedStrides, inner, outer) +
+    "permuteOutput[outputOffset + n] = permuteInput[inputOffset + n];\n"
+    "}\n";
+  } else {
+    // Every slice of the other axes is a matrix to transpose
+    transposeConf sliceConf = conf;
+    std::string * body = 0;
+
+    // Vector accesses also need every slice to start aligned
+    if ( (nrAxes > 2) && ((inputStrides[nrAxes - 2] % conf.getVectorWidth() != 0) || (outputStrides[nrAxes - 2] % conf.getVectorWidth() != 0)) ) {
+      sliceConf.setVectorWidth(1);
+    }
+    body = getTransposeBody(sliceConf, shape[outer], shape[inner], inputStrides[outer], permutedStrides[inner], vector, typeName, typeName, false);
+    *code += getPermuteOffsets("get_group_id(2)", shape, inputStrides, permutedStrides, inner, outer) +
+    "__global const " + typeName + " * const restrict input = permuteInput + inputOffset;\n"
+    "__global " + typeName + " * const restrict output = permuteOutput + outputOffset;\n"
+    + *body;
+    delete body;
+  }
+  *code += "}\n";
+  // End kernel's template
+
+  return code;
+}
+
+std::vector< unsigned int > getPermuteGlobalSize(const transposeConf & conf, const std::vector< unsigned int > & shape, const std::vector< unsigned int > & permutation) {
+  const unsigned int inner = getPermuteShape(shape, permutation).size() - 1;
+  const unsigned int outer = permutation[inner];
+  std::vector< unsigned int > globalSize(3);
+  unsigned int nrRows = 1;
+  unsigned int nrSlices = 1;
+
+  for ( unsigned int axis = 0; axis < shape.size(); axis++ ) {
+    if ( axis != inner ) {
+      nrRows *= shape[axis];
+    }
+    if ( axis != inner && axis != outer ) {
+      nrSlices *= shape[axis];
+    }
+  }
+  if ( inner == outer ) {
+    globalSize[0] = std::ceil(static_cast< double >(nrRows) / conf.getTileHeight()) * conf.getNrThreads();
+    globalSize[2] = 1;
+  } else {
+    globalSize[0] = std::ceil(static_cast< double >(shape[outer]) / conf.getTileHeight()) * conf.getNrThreads();
+    globalSize[2] = nrSlices;
+  }
+  globalSize[1] = std::ceil(static_cast< double >(shape[inner]) / conf.getTileWidth());
+  return globalSize;
+}
+
+} // OpenCL
+} // isa
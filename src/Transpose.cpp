@@ -12,61 +12,593 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <sstream>
+
 #include <Transpose.hpp>
+#include <TransposeSIMD.hpp>
 
 namespace isa {
 namespace OpenCL {
 
-transposeConf::transposeConf() {}
+transposeConf::transposeConf() : tileWidth(1), tileHeight(1), nrItemsPerThread(1), localPadding(0), vectorWidth(1), directWrite(0), diagonal(0) {}
 
 transposeConf::~transposeConf() {}
 
 std::string transposeConf::print() const {
-  return std::string(isa::utils::toString(nrItemsPerBlock));
+  return isa::utils::toString(tileWidth) + " " + isa::utils::toString(tileHeight) + " " + isa::utils::toString(nrItemsPerThread) + " " + isa::utils::toString(localPadding) + " " + isa::utils::toString(vectorWidth) + " " + isa::utils::toString(directWrite) + " " + isa::utils::toString(diagonal);
+}
+
+void splitTransposeBlock(const transposeBlock & block, const unsigned int alignment, transposeBlock & first, transposeBlock & second) {
+  first = block;
+  second = block;
+  if ( block.endM - block.beginM >= block.endN - block.beginN ) {
+    unsigned int half = (block.endM - block.beginM) / 2;
+
+    if ( half > alignment ) {
+      half -= half % alignment;
+    }
+    first.endM = block.beginM + half;
+    second.beginM = first.endM;
+  } else {
+    unsigned int half = (block.endN - block.beginN) / 2;
+
+    if ( half > alignment ) {
+      half -= half % alignment;
+    }
+    first.endN = block.beginN + half;
+    second.beginN = first.endN;
+  }
+}
+
+void processTransposeBlocks(const unsigned int M, const unsigned int N, const unsigned int grain, const unsigned int alignment, unsigned int nrThreads, const std::function< void(const transposeBlock & block) > & process) {
+  // Every worker splits from the back of its own deque, idle workers steal the larger blocks from the front of the others
+  struct workerBlocks {
+    std::mutex mutex;
+    std::deque< transposeBlock > blocks;
+  };
+  std::atomic< unsigned int > nrPending(1);
+  std::vector< std::thread > pool;
+
+  if ( nrThreads == 0 ) {
+    nrThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  std::vector< workerBlocks > workers(nrThreads);
+
+  workers[0].blocks.push_back({0, M, 0, N});
+  auto worker = [&](const unsigned int id) {
+    while ( nrPending > 0 ) {
+      transposeBlock block;
+      bool found = false;
+
+      for ( unsigned int victim = 0; ! found && victim < nrThreads; victim++ ) {
+        workerBlocks & other = workers[(id + victim) % nrThreads];
+        std::lock_guard< std::mutex > lock(other.mutex);
+
+        if ( ! other.blocks.empty() ) {
+          if ( victim == 0 ) {
+            block = other.blocks.back();
+            other.blocks.pop_back();
+          } else {
+            block = other.blocks.front();
+            other.blocks.pop_front();
+          }
+          found = true;
+        }
+      }
+      if ( ! found ) {
+        std::this_thread::yield();
+        continue;
+      }
+      while ( static_cast< long long unsigned int >(block.endM - block.beginM) * (block.endN - block.beginN) > grain ) {
+        transposeBlock first;
+        transposeBlock second;
+
+        splitTransposeBlock(block, alignment, first, second);
+        block = first;
+        nrPending++;
+        std::lock_guard< std::mutex > lock(workers[id].mutex);
+        workers[id].blocks.push_back(second);
+      }
+      process(block);
+      nrPending--;
+    }
+  };
+
+  for ( unsigned int thread = 1; thread < nrThreads; thread++ ) {
+    pool.push_back(std::thread(worker, thread));
+  }
+  worker(0);
+  for ( std::vector< std::thread >::iterator thread = pool.begin(); thread != pool.end(); ++thread ) {
+    thread->join();
+  }
+}
+
+hostSIMD getHostSIMD() {
+#ifdef TRANSPOSE_X86
+  static const hostSIMD simd = __builtin_cpu_supports("avx512f") ? SIMD_AVX512 : (__builtin_cpu_supports("avx2") ? SIMD_AVX2 : (__builtin_cpu_supports("sse2") ? SIMD_SSE : SIMD_NONE));
+
+  return simd;
+#else
+  return SIMD_NONE;
+#endif
+}
+
+transposeTileKernel getTransposeTileKernel(const std::size_t typeSize, unsigned int & tileSize, const hostSIMD simd) {
+  tileSize = 1;
+#ifdef TRANSPOSE_X86
+  if ( typeSize == 4 ) {
+    switch ( simd ) {
+      case SIMD_AVX512:
+        tileSize = 16;
+        return transposeTile16x16AVX512;
+      case SIMD_AVX2:
+        tileSize = 8;
+        return transposeTile8x8AVX2;
+      case SIMD_SSE:
+        tileSize = 4;
+        return transposeTile4x4SSE;
+      default:
+        break;
+    }
+  } else if ( typeSize == 8 ) {
+    switch ( simd ) {
+      case SIMD_AVX512:
+        tileSize = 8;
+        return transposeTile8x8AVX512;
+      case SIMD_AVX2:
+        tileSize = 4;
+        return transposeTile4x4AVX2;
+      case SIMD_SSE:
+        tileSize = 2;
+        return transposeTile2x2SSE;
+      default:
+        break;
+    }
+  }
+#endif
+  return 0;
+}
+
+// OpenCL expression converting value, of width elements, to outputTypeName; integers are rounded to nearest and saturated
+static std::string getConversion(const std::string & value, const std::string & inputTypeName, const std::string & outputTypeName, const bool scale, const unsigned int width) {
+  std::string width_s = (width > 1) ? isa::utils::toString(width) : "";
+  std::string scaleTypeName = getTransposeScaleType(outputTypeName);
+  std::string rounding = (outputTypeName == "float" || outputTypeName == "double" || outputTypeName == "half") ? "" : "_sat_rte";
+
+  if ( ! scale ) {
+    if ( inputTypeName == outputTypeName ) {
+      return value;
+    }
+    return "convert_" + outputTypeName + width_s + rounding + "(" + value + ")";
+  }
+  std::string scaled = "((convert_" + scaleTypeName + width_s + "(" + value + ") * scale) + offset)";
+
+  if ( outputTypeName == scaleTypeName ) {
+    return scaled;
+  }
+  return "convert_" + outputTypeName + width_s + rounding + "(" + scaled + ")";
+}
+
+std::string getTransposeScaleType(const std::string & outputTypeName) {
+  return (outputTypeName == "double") ? "double" : "float";
+}
+
+unsigned int getTransposeTypeWidth(const std::string & typeName) {
+  std::size_t digits = typeName.find_first_of("0123456789");
+
+  if ( digits == std::string::npos ) {
+    return 1;
+  }
+  return isa::utils::castToType< std::string, unsigned int >(typeName.substr(digits));
+}
+
+std::string getTransposeStorageType(const std::string & typeName) {
+  if ( typeName.compare(0, 4, "half") == 0 ) {
+    return "ushort" + typeName.substr(4);
+  }
+  return typeName;
+}
+
+std::string getTransposeExtensions(const std::string & inputTypeName, const std::string & outputTypeName) {
+  std::string extensions;
+
+  if ( (inputTypeName.compare(0, 6, "double") == 0) || (outputTypeName.compare(0, 6, "double") == 0) ) {
+    extensions += "#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n";
+  }
+  if ( (inputTypeName.compare(0, 4, "half") == 0) || (outputTypeName.compare(0, 4, "half") == 0) ) {
+    extensions += "#pragma OPENCL EXTENSION cl_khr_fp16 : enable\n";
+  }
+  return extensions;
+}
+
+std::string * getTransposeBody(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int inputStride, const unsigned int outputStride, const unsigned int vector, std::string inputTypeName, std::string outputTypeName, const bool scale) {
+  std::string * code = new std::string();
+  std::string inputStride_s = isa::utils::toString(inputStride);
+  std::string outputStride_s = isa::utils::toString(outputStride);
+  std::string width_s = isa::utils::toString(conf.getTileWidth());
+  std::string height_s = isa::utils::toString(conf.getTileHeight());
+  std::string nrThreads_s = isa::utils::toString(conf.getNrThreads());
+  unsigned int vectorWidth = conf.getVectorWidth();
+  // The last row of tiles is partial when M is not a multiple of the tile height
+  bool partialM = (M % conf.getTileHeight()) != 0;
+  std::string M_s = isa::utils::toString(M);
+  const bool direct = conf.getDirectWrite() != 0;
+  // The tile is stored in local memory row by row, or column by column with direct writes; the padding breaks the power of two stride of the strided side
+  const unsigned int localStride = direct ? conf.getTileHeight() + conf.getLocalPadding() : conf.getTileWidth() + conf.getLocalPadding();
+  std::string localStride_s = isa::utils::toString(localStride);
+  const unsigned int nrTilesM = (M + conf.getTileHeight() - 1) / conf.getTileHeight();
+  const unsigned int nrTilesN = (N + conf.getTileWidth() - 1) / conf.getTileWidth();
+  // Position of element (m, n) of the tile in local memory
+  auto local = [&](const std::string & m, const std::string & n) {
+    const std::string & row = direct ? n : m;
+    const std::string & column = direct ? m : n;
+
+    return "tempStorage[(" + ((row.find(' ') == std::string::npos) ? row : "(" + row + ")") + " * " + localStride_s + ") + " + column + "]";
+  };
+
+  // Vector accesses need whole vectors in the tile and aligned rows, and scalar elements: there are no vectors of vectors
+  if ( (conf.getTileWidth() % vectorWidth != 0) || (conf.getTileHeight() % vectorWidth != 0) || (inputStride % vectorWidth != 0) || (outputStride % vectorWidth != 0) || (getTransposeTypeWidth(inputTypeName) > 1) || (getTransposeTypeWidth(outputTypeName) > 1) ) {
+    vectorWidth = 1;
+  }
+
+  if ( conf.getDiagonal() ) {
+    // Consecutive work-groups take tiles on a diagonal of the matrix, so they do not all hit the same rows of the input and of the output
+    *code = "const unsigned int groupID = get_group_id(0) + (get_group_id(1) * " + isa::utils::toString(nrTilesM) + ");\n"
+    "const unsigned int tileN = groupID % " + isa::utils::toString(nrTilesN) + ";\n"
+    "const unsigned int baseM = (((groupID / " + isa::utils::toString(nrTilesN) + ") + tileN) % " + isa::utils::toString(nrTilesM) + ") * " + height_s + ";\n"
+    "const unsigned int baseN = tileN * " + width_s + ";\n";
+  } else {
+    *code = "const unsigned int baseM = get_group_id(0) * " + height_s + ";\n"
+    "const unsigned int baseN = get_group_id(1) * " + width_s + ";\n";
+  }
+  *code += "__local "+ outputTypeName + " tempStorage[" + isa::utils::toString((direct ? conf.getTileWidth() : conf.getTileHeight()) * localStride) + "];\n";
+  if ( (conf.getTileWidth() == conf.getTileHeight()) && (conf.getNrThreads() == conf.getTileWidth()) && (vectorWidth == 1) ) {
+    // One work-item per column of a square tile
+    std::string items_s = width_s;
+
+    // Load input
+    *code += "for ( unsigned int m = 0; m < " + items_s + "; m++ ) {\n"
+    "if ( (baseN + get_local_id(0) < " + isa::utils::toString(N) + ")" + (partialM ? " && (baseM + m < " + M_s + ")" : "") + " ) {\n"
+    + local("m", "get_local_id(0)") + " = " + getConversion("input[((baseM + m) * " + inputStride_s + ") + (baseN + get_local_id(0))]", inputTypeName, outputTypeName, scale, 1) + ";\n"
+    "}\n"
+    "}\n";
+    if ( conf.getNrThreads() > vector ) {
+      *code += "barrier(CLK_LOCAL_MEM_FENCE);\n";
+    }
+    if ( ! direct ) {
+      // Local in-place transpose
+      *code += "for ( unsigned int i = 1; i <= " + items_s + " / 2; i++ ) {\n"
+      "unsigned int localItem = (get_local_id(0) + i) % " + items_s + ";\n";
+      if ( conf.getNrThreads() == vector ) {
+        *code += "if ( (i < "+ items_s + ") || (get_local_id(0) < " + items_s + " / 2) ) {\n";
+      } else {
+        *code += "if ( (i < "+ items_s + " - " + isa::utils::toString(conf.getTileWidth() / 2) + ") || (get_local_id(0) < " + items_s + " / 2) ) {\n";
+      }
+      // No initializer, the literal 0 is not a valid value of every element type
+      *code += "const " + outputTypeName + " temp = tempStorage[(get_local_id(0) * " + localStride_s + ") + localItem];\n"
+      "tempStorage[(get_local_id(0) * " + localStride_s + ") + localItem] = tempStorage[(localItem * " + localStride_s + ") + get_local_id(0)];\n"
+      "tempStorage[(localItem * " + localStride_s + ") + get_local_id(0)] = temp;\n"
+      "}\n"
+      "}\n";
+      if ( conf.getNrThreads() > vector ) {
+        *code += "barrier(CLK_LOCAL_MEM_FENCE);\n";
+      }
+    }
+    // Store output, work-item i writes element i of every output row; the tile is transposed in local memory either way
+    *code += "for ( unsigned int n = 0; n < " + items_s + "; n++ ) {\n"
+    "if ( (baseN + n < " + isa::utils::toString(N) + ")" + (partialM ? " && (baseM + get_local_id(0) < " + M_s + ")" : "") + " ) {\n"
+    "output[((baseN + n) * " + outputStride_s + ") + (baseM + get_local_id(0))] = tempStorage[(n * " + localStride_s + ") + get_local_id(0)];\n"
+    "}\n"
+    "}\n";
+  } else if ( vectorWidth > 1 ) {
+    // Rectangular tile, with vector accesses to global memory and a scalar path for partial vectors
+    std::string vectorWidth_s = isa::utils::toString(vectorWidth);
+    std::string nrVectors_s = isa::utils::toString((conf.getTileWidth() * conf.getTileHeight()) / vectorWidth);
+    std::string vectorType = outputTypeName + vectorWidth_s;
+
+    // Load input
+    *code += "for ( unsigned int item = get_local_id(0); item < " + nrVectors_s + "; item += " + nrThreads_s + " ) {\n"
+    "const unsigned int m = item / " + isa::utils::toString(conf.getTileWidth() / vectorWidth) + ";\n"
+    "const unsigned int n = (item % " + isa::utils::toString(conf.getTileWidth() / vectorWidth) + ") * " + vectorWidth_s + ";\n";
+    if ( partialM ) {
+      *code += "if ( baseM + m >= " + M_s + " ) {\n"
+      "continue;\n"
+      "}\n";
+    }
+    *code += "if ( baseN + n + " + vectorWidth_s + " <= " + isa::utils::toString(N) + " ) {\n";
+    if ( direct ) {
+      // Scatter the vector over a row of the transposed tile
+      *code += "const " + vectorType + " temp = " + getConversion("vload" + vectorWidth_s + "(0, input + ((baseM + m) * " + inputStride_s + ") + (baseN + n))", inputTypeName, outputTypeName, scale, vectorWidth) + ";\n";
+      for ( unsigned int k = 0; k < vectorWidth; k++ ) {
+        *code += local("m", "n + " + isa::utils::toString(k)) + " = temp.s" + "0123456789abcdef"[k] + ";\n";
+      }
+    } else {
+      *code += "vstore" + vectorWidth_s + "(" + getConversion("vload" + vectorWidth_s + "(0, input + ((baseM + m) * " + inputStride_s + ") + (baseN + n))", inputTypeName, outputTypeName, scale, vectorWidth) + ", 0, tempStorage + (m * " + localStride_s + ") + n);\n";
+    }
+    *code += "} else {\n"
+    "for ( unsigned int k = 0; (k < " + vectorWidth_s + ") && (baseN + n + k < " + isa::utils::toString(N) + "); k++ ) {\n"
+    + local("m", "n + k") + " = " + getConversion("input[((baseM + m) * " + inputStride_s + ") + (baseN + n + k)]", inputTypeName, outputTypeName, scale, 1) + ";\n"
+    "}\n"
+    "}\n"
+    "}\n";
+    if ( conf.getNrThreads() > vector ) {
+      *code += "barrier(CLK_LOCAL_MEM_FENCE);\n";
+    }
+    // Store output, each vector is a column of the tile
+    *code += "for ( unsigned int item = get_local_id(0); item < " + nrVectors_s + "; item += " + nrThreads_s + " ) {\n"
+    "const unsigned int n = item / " + isa::utils::toString(conf.getTileHeight() / vectorWidth) + ";\n"
+    "const unsigned int m = (item % " + isa::utils::toString(conf.getTileHeight() / vectorWidth) + ") * " + vectorWidth_s + ";\n"
+    "if ( baseN + n >= " + isa::utils::toString(N) + " ) {\n"
+    "continue;\n"
+    "}\n";
+    if ( partialM ) {
+      *code += "if ( baseM + m + " + vectorWidth_s + " > " + M_s + " ) {\n"
+      "for ( unsigned int k = 0; baseM + m + k < " + M_s + "; k++ ) {\n"
+      "output[((baseN + n) * " + outputStride_s + ") + (baseM + m + k)] = " + local("m + k", "n") + ";\n"
+      "}\n"
+      "continue;\n"
+      "}\n";
+    }
+    if ( direct ) {
+      // The column is contiguous in local memory
+      *code += "vstore" + vectorWidth_s + "(vload" + vectorWidth_s + "(0, tempStorage + (n * " + localStride_s + ") + m), 0, output + ((baseN + n) * " + outputStride_s + ") + (baseM + m));\n";
+    } else {
+      // Gather the column
+      *code += "vstore" + vectorWidth_s + "((" + vectorType + ")(";
+      for ( unsigned int k = 0; k < vectorWidth; k++ ) {
+        if ( k > 0 ) {
+          *code += ", ";
+        }
+        *code += "tempStorage[((m + " + isa::utils::toString(k) + ") * " + localStride_s + ") + n]";
+      }
+      *code += "), 0, output + ((baseN + n) * " + outputStride_s + ") + (baseM + m));\n";
+    }
+    *code += "}\n";
+  } else {
+    // Rectangular tile, the work-items read it transposed from local memory
+    std::string nrItems_s = isa::utils::toString(conf.getTileWidth() * conf.getTileHeight());
+
+    // Load input
+    *code += "for ( unsigned int item = get_local_id(0); item < " + nrItems_s + "; item += " + nrThreads_s + " ) {\n"
+    "const unsigned int m = item / " + width_s + ";\n"
+    "const unsigned int n = item % " + width_s + ";\n"
+    "if ( (baseN + n < " + isa::utils::toString(N) + ")" + (partialM ? " && (baseM + m < " + M_s + ")" : "") + " ) {\n"
+    + local("m", "n") + " = " + getConversion("input[((baseM + m) * " + inputStride_s + ") + (baseN + n)]", inputTypeName, outputTypeName, scale, 1) + ";\n"
+    "}\n"
+    "}\n";
+    if ( conf.getNrThreads() > vector ) {
+      *code += "barrier(CLK_LOCAL_MEM_FENCE);\n";
+    }
+    // Store output
+    *code += "for ( unsigned int item = get_local_id(0); item < " + nrItems_s + "; item += " + nrThreads_s + " ) {\n"
+    "const unsigned int n = item / " + height_s + ";\n"
+    "const unsigned int m = item % " + height_s + ";\n"
+    "if ( (baseN + n < " + isa::utils::toString(N) + ")" + (partialM ? " && (baseM + m < " + M_s + ")" : "") + " ) {\n"
+    "output[((baseN + n) * " + outputStride_s + ") + (baseM + m)] = " + local("m", "n") + ";\n"
+    "}\n"
+    "}\n";
+  }
+
+  return code;
 }
 
 std::string * getTransposeOpenCL(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int vector, std::string typeName) {
+  return getTransposeOpenCL(conf, M, N, padding, vector, typeName, typeName, false);
+}
+
+std::string * getTransposeOpenCL(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int vector, std::string inputTypeName, std::string outputTypeName, const bool scale) {
   std::string * code = new std::string();
 
+  if ( (inputTypeName == outputTypeName) && ! scale ) {
+    inputTypeName = getTransposeStorageType(inputTypeName);
+    outputTypeName = inputTypeName;
+  }
+  std::string * body = getTransposeBody(conf, M, N, isa::utils::pad(N, padding), isa::utils::pad(M, padding), vector, inputTypeName, outputTypeName, scale);
+  std::string scaleArguments;
+
+  if ( scale ) {
+    scaleArguments = ", const " + getTransposeScaleType(outputTypeName) + " scale, const " + getTransposeScaleType(outputTypeName) + " offset";
+  }
   // Begin kernel's template
-	*code = "__kernel void transpose(__global const " + typeName + " * const restrict input, __global " + typeName + " * const restrict output) {\n"
-	"const unsigned int baseM = get_group_id(0) * " + isa::utils::toString(conf.getNrItemsPerBlock()) + ";\n"
-	"const unsigned int baseN = get_group_id(1) * " + isa::utils::toString(conf.getNrItemsPerBlock()) + ";\n"
-	"__local "+ typeName + " tempStorage[" + isa::utils::toString(conf.getNrItemsPerBlock() * conf.getNrItemsPerBlock()) + "];"
-	"\n"
-	// Load input
-	"for ( unsigned int m = 0; m < " + isa::utils::toString(conf.getNrItemsPerBlock()) + "; m++ ) {\n"
-	"if ( baseN + get_local_id(0) < " + isa::utils::toString(N) + " ) {\n"
-	"tempStorage[(m * " + isa::utils::toString(conf.getNrItemsPerBlock()) + ") + get_local_id(0)] = input[((baseM + m) * " + isa::utils::toString(isa::utils::pad(N, padding)) + ") + (baseN + get_local_id(0))];\n"
-	"}\n"
-	"}\n";
-	if ( conf.getNrItemsPerBlock() > vector ) {
-		*code += "barrier(CLK_LOCAL_MEM_FENCE);\n";
-	}
-	// Local in-place transpose
-	*code += "for ( unsigned int i = 1; i <= " + isa::utils::toString(conf.getNrItemsPerBlock()) + " / 2; i++ ) {\n"
-	"unsigned int localItem = (get_local_id(0) + i) % " + isa::utils::toString(conf.getNrItemsPerBlock()) + ";\n"
-	+ typeName + " temp = 0;\n";
-	if ( conf.getNrItemsPerBlock() == vector ) {
-		*code += "if ( (i < "+ isa::utils::toString(conf.getNrItemsPerBlock()) + ") || (get_local_id(0) < " + isa::utils::toString(conf.getNrItemsPerBlock()) + " / 2) ) {\n";
-	} else {
-		*code += "if ( (i < "+ isa::utils::toString(conf.getNrItemsPerBlock()) + " - " + isa::utils::toString(conf.getNrItemsPerBlock() / 2) + ") || (get_local_id(0) < " + isa::utils::toString(conf.getNrItemsPerBlock()) + " / 2) ) {\n";
-	}
-	*code += "temp = tempStorage[(get_local_id(0) * " + isa::utils::toString(conf.getNrItemsPerBlock()) + ") + localItem];\n"
-	"tempStorage[(get_local_id(0) * " + isa::utils::toString(conf.getNrItemsPerBlock()) + ") + localItem] = tempStorage[(localItem * " + isa::utils::toString(conf.getNrItemsPerBlock()) + ") + get_local_id(0)];\n"
-	"tempStorage[(localItem * " + isa::utils::toString(conf.getNrItemsPerBlock()) + ") + get_local_id(0)] = temp;\n"
-	"}\n"
-	"}\n";
-	if ( conf.getNrItemsPerBlock() > vector ) {
-		*code += "barrier(CLK_LOCAL_MEM_FENCE);\n";
-	}
-	// Store output
-	*code += "for ( unsigned int n = 0; n < " + isa::utils::toString(conf.getNrItemsPerBlock()) + "; n++ ) {\n"
-	"if ( baseN + n < " + isa::utils::toString(N) + " ) {\n"
-	"output[((baseN + n) * " + isa::utils::toString(isa::utils::pad(M, padding)) + ") + (baseM + get_local_id(0))] = tempStorage[(n * " + isa::utils::toString(conf.getNrItemsPerBlock()) + ") + get_local_id(0)];"
-	"}\n"
-	"}\n"
-	"}\n";
+  *code = getTransposeExtensions(inputTypeName, outputTypeName)
+  + "__kernel void transpose(__global const " + inputTypeName + " * const restrict input, __global " + outputTypeName + " * const restrict output" + scaleArguments + ") {\n"
+  + *body +
+  "}\n";
+  // End kernel's template
+  delete body;
+
+  return code;
+}
+
+std::string * getTransposeBatchedOpenCL(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int vector, std::string typeName, const unsigned int inputBatchStride, const unsigned int outputBatchStride) {
+  std::string * code = new std::string();
+
+  typeName = getTransposeStorageType(typeName);
+  std::string * body = getTransposeBody(conf, M, N, isa::utils::pad(N, padding), isa::utils::pad(M, padding), vector, typeName, typeName, false);
+
+  // Begin kernel's template
+  *code = getTransposeExtensions(typeName, typeName)
+  + "__kernel void transposeBatched(__global const " + typeName + " * const restrict batchedInput, __global " + typeName + " * const restrict batchedOutput) {\n"
+  "__global const " + typeName + " * const restrict input = batchedInput + (get_group_id(2) * " + isa::utils::toString(inputBatchStride) + ");\n"
+  "__global " + typeName + " * const restrict output = batchedOutput + (get_group_id(2) * " + isa::utils::toString(outputBatchStride) + ");\n"
+  + *body +
+  "}\n";
+  // End kernel's template
+  delete body;
+
+  return code;
+}
+
+std::string * getTransposeViewOpenCL(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int inputLeadingDimension, const unsigned int outputLeadingDimension, const unsigned int vector, std::string typeName) {
+  std::string * code = new std::string();
+
+  typeName = getTransposeStorageType(typeName);
+  std::string * body = getTransposeBody(conf, M, N, inputLeadingDimension, outputLeadingDimension, vector, typeName, typeName, false);
+
+  // Begin kernel's template
+  *code = getTransposeExtensions(typeName, typeName)
+  + "__kernel void transposeView(__global const " + typeName + " * const restrict inputMatrix, __global " + typeName + " * const restrict outputMatrix, const unsigned int inputOffset, const unsigned int outputOffset) {\n"
+  "__global const " + typeName + " * const restrict input = inputMatrix + inputOffset;\n"
+  "__global " + typeName + " * const restrict output = outputMatrix + outputOffset;\n"
+  + *body +
+  "}\n";
+  // End kernel's template
+  delete body;
+
+  return code;
+}
+
+matrixView readMatrixView(const std::string & view) {
+  std::vector< unsigned int > values;
+  std::istringstream stream(view);
+  std::string value;
+  matrixView parsed;
+
+  while ( std::getline(stream, value, ':') ) {
+    values.push_back(isa::utils::castToType< std::string, unsigned int >(value));
+  }
+  if ( values.size() != 3 ) {
+    throw std::invalid_argument("A view is firstRow:firstColumn:leadingDimension, not " + view + ".");
+  }
+  parsed.firstRow = values[0];
+  parsed.firstColumn = values[1];
+  parsed.leadingDimension = values[2];
+  return parsed;
+}
+
+std::size_t getMatrixViewOffset(const matrixView & view) {
+  return (static_cast< std::size_t >(view.firstRow) * view.leadingDimension) + view.firstColumn;
+}
+
+std::size_t getMatrixViewSize(const unsigned int rows, const matrixView & view) {
+  return static_cast< std::size_t >(view.firstRow + rows) * view.leadingDimension;
+}
+
+void checkMatrixView(const unsigned int rows, const unsigned int columns, const matrixView & view, const std::size_t size) {
+  if ( view.firstColumn + columns > view.leadingDimension ) {
+    throw std::out_of_range("The view is wider than the leading dimension.");
+  }
+  if ( (rows > 0) && (getMatrixViewOffset(view) + (static_cast< std::size_t >(rows - 1) * view.leadingDimension) + columns > size) ) {
+    throw std::out_of_range("The view does not fit in the matrix.");
+  }
+}
+
+unsigned int getTransposeInPlaceSize(const unsigned int M, const unsigned int N, const unsigned int padding) {
+  return std::max(M * isa::utils::pad(N, padding), N * isa::utils::pad(M, padding));
+}
+
+std::vector< unsigned int > getTransposeInPlaceLeaders(const unsigned int M, const unsigned int N, const unsigned int padding) {
+  const unsigned int inputStride = isa::utils::pad(N, padding);
+  const unsigned int outputStride = isa::utils::pad(M, padding);
+  std::vector< unsigned int > leaders;
+  std::vector< bool > visited(M * inputStride, false);
+
+  // Chains that start from an element whose position is not a destination, and end in a padding or free position
+  for ( unsigned int item = 0; item < M * inputStride; item++ ) {
+    if ( (item % inputStride) >= N || ((item < N * outputStride) && ((item % outputStride) < M)) ) {
+      continue;
+    }
+    leaders.push_back(item);
+    for ( unsigned int next = item; (next < M * inputStride) && ((next % inputStride) < N); next = ((next % inputStride) * outputStride) + (next / inputStride) ) {
+      visited[next] = true;
+    }
+  }
+  // Cycles made only of elements
+  for ( unsigned int item = 0; item < M * inputStride; item++ ) {
+    unsigned int next = ((item % inputStride) * outputStride) + (item / inputStride);
+
+    if ( (item % inputStride) >= N || visited[item] || next == item ) {
+      continue;
+    }
+    leaders.push_back(item);
+    visited[item] = true;
+    for ( ; next != item; next = ((next % inputStride) * outputStride) + (next / inputStride) ) {
+      visited[next] = true;
+    }
+  }
+
+  return leaders;
+}
+
+std::string * getTransposeInPlaceOpenCL(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int vector, std::string typeName) {
+  std::string * code = new std::string();
+  std::string items_s = isa::utils::toString(conf.getTileWidth());
+  std::string inputStride_s = isa::utils::toString(isa::utils::pad(N, padding));
+  std::string outputStride_s = isa::utils::toString(isa::utils::pad(M, padding));
+
+  typeName = getTransposeStorageType(typeName);
+  *code = getTransposeExtensions(typeName, typeName);
+  if ( M == N ) {
+    // Each work-group swaps a tile above the diagonal with its mirror below it; tiles are tileWidth x tileWidth, with one work-item per column
+    *code += "__kernel void transposeInPlace(__global " + typeName + " * const restrict data) {\n"
+    "if ( get_group_id(0) > get_group_id(1) ) {\n"
+    "return;\n"
+    "}\n"
+    "const unsigned int baseM = get_group_id(0) * " + items_s + ";\n"
+    "const unsigned int baseN = get_group_id(1) * " + items_s + ";\n"
+    "__local " + typeName + " upperTile[" + isa::utils::toString(conf.getTileWidth() * conf.getTileWidth()) + "];\n"
+    "__local " + typeName + " lowerTile[" + isa::utils::toString(conf.getTileWidth() * conf.getTileWidth()) + "];\n"
+    "\n"
+    // Load both tiles
+    "for ( unsigned int m = 0; m < " + items_s + "; m++ ) {\n"
+    "if ( (baseM + m < " + isa::utils::toString(M) + ") && (baseN + get_local_id(0) < " + isa::utils::toString(N) + ") ) {\n"
+    "upperTile[(m * " + items_s + ") + get_local_id(0)] = data[((baseM + m) * " + inputStride_s + ") + (baseN + get_local_id(0))];\n"
+    "}\n"
+    "if ( (baseN + m < " + isa::utils::toString(N) + ") && (baseM + get_local_id(0) < " + isa::utils::toString(M) + ") ) {\n"
+    "lowerTile[(m * " + items_s + ") + get_local_id(0)] = data[((baseN + m) * " + inputStride_s + ") + (baseM + get_local_id(0))];\n"
+    "}\n"
+    "}\n";
+    if ( conf.getTileWidth() > vector ) {
+      *code += "barrier(CLK_LOCAL_MEM_FENCE);\n";
+    }
+    // Store them transposed in each other's place
+    *code += "for ( unsigned int n = 0; n < " + items_s + "; n++ ) {\n"
+    "if ( (baseN + n < " + isa::utils::toString(N) + ") && (baseM + get_local_id(0) < " + isa::utils::toString(M) + ") ) {\n"
+    "data[((baseN + n) * " + outputStride_s + ") + (baseM + get_local_id(0))] = upperTile[(get_local_id(0) * " + items_s + ") + n];\n"
+    "}\n"
+    "if ( (baseM + n < " + isa::utils::toString(M) + ") && (baseN + get_local_id(0) < " + isa::utils::toString(N) + ") ) {\n"
+    "data[((baseM + n) * " + outputStride_s + ") + (baseN + get_local_id(0))] = lowerTile[(get_local_id(0) * " + items_s + ") + n];\n"
+    "}\n"
+    "}\n"
+    "}\n";
+  } else {
+    // Each work-item follows one of the chains from getTransposeInPlaceLeaders()
+    *code += "__kernel void transposeInPlace(__global " + typeName + " * const restrict data, __global const unsigned int * const restrict leaders, const unsigned int nrLeaders) {\n"
+    "if ( get_global_id(0) >= nrLeaders ) {\n"
+    "return;\n"
+    "}\n"
+    "const unsigned int leader = leaders[get_global_id(0)];\n"
+    "unsigned int item = ((leader % " + inputStride_s + ") * " + outputStride_s + ") + (leader / " + inputStride_s + ");\n"
+    + typeName + " temp = data[leader];\n"
+    "\n"
+    "while ( (item < " + isa::utils::toString(M * isa::utils::pad(N, padding)) + ") && ((item % " + inputStride_s + ") < " + isa::utils::toString(N) + ") && (item != leader) ) {\n"
+    + typeName + " swap = data[item];\n"
+    "data[item] = temp;\n"
+    "temp = swap;\n"
+    "item = ((item % " + inputStride_s + ") * " + outputStride_s + ") + (item / " + inputStride_s + ");\n"
+    "}\n"
+    "data[item] = temp;\n"
+    "}\n";
+  }
+
+  return code;
+}
+
+std::string * getCopyOpenCL(const unsigned int nrElements, std::string typeName) {
+  std::string * code = new std::string();
+
+  typeName = getTransposeStorageType(typeName);
+  // Begin kernel's template
+  *code = getTransposeExtensions(typeName, typeName)
+  + "__kernel void copy(__global const " + typeName + " * const restrict input, __global " + typeName + " * const restrict output) {\n"
+  "const unsigned int item = get_global_id(0);\n"
+  "if ( item < " + isa::utils::toString(nrElements) + " ) {\n"
+  "output[item] = input[item];\n"
+  "}\n"
+  "}\n";
   // End kernel's template
 
   return code;
@@ -76,11 +608,10 @@ void readTunedTransposeConf(tunedTransposeConf & tunedTranspose, const std::stri
 	std::string temp;
 	std::ifstream transposeFile(transposeFilename);
 
-	while ( ! transposeFile.eof() ) {
+	while ( std::getline(transposeFile, temp) ) {
 		unsigned int splitPoint = 0;
 
-		std::getline(transposeFile, temp);
-		if ( ! std::isalpha(temp[0]) ) {
+		if ( temp.empty() || ! std::isalpha(temp[0]) ) {
 			continue;
 		}
 		std::string deviceName;
@@ -93,7 +624,25 @@ void readTunedTransposeConf(tunedTransposeConf & tunedTranspose, const std::stri
 		splitPoint = temp.find(" ");
 		nrDMs = isa::utils::castToType< std::string, unsigned int >(temp.substr(0, splitPoint));
 		temp = temp.substr(splitPoint + 1);
-		parameters.setNrItemsPerBlock(isa::utils::castToType< std::string, unsigned int >(temp));
+		splitPoint = temp.find(" ");
+		parameters.setTileWidth(isa::utils::castToType< std::string, unsigned int >(temp.substr(0, splitPoint)));
+		temp = temp.substr(splitPoint + 1);
+		splitPoint = temp.find(" ");
+		parameters.setTileHeight(isa::utils::castToType< std::string, unsigned int >(temp.substr(0, splitPoint)));
+		temp = temp.substr(splitPoint + 1);
+		splitPoint = temp.find(" ");
+		parameters.setNrItemsPerThread(isa::utils::castToType< std::string, unsigned int >(temp.substr(0, splitPoint)));
+		temp = temp.substr(splitPoint + 1);
+		splitPoint = temp.find(" ");
+		parameters.setLocalPadding(isa::utils::castToType< std::string, unsigned int >(temp.substr(0, splitPoint)));
+		temp = temp.substr(splitPoint + 1);
+		splitPoint = temp.find(" ");
+		parameters.setVectorWidth(isa::utils::castToType< std::string, unsigned int >(temp.substr(0, splitPoint)));
+		temp = temp.substr(splitPoint + 1);
+		splitPoint = temp.find(" ");
+		parameters.setDirectWrite(isa::utils::castToType< std::string, unsigned int >(temp.substr(0, splitPoint)));
+		temp = temp.substr(splitPoint + 1);
+		parameters.setDiagonal(isa::utils::castToType< std::string, unsigned int >(temp));
 
 		if ( tunedTranspose.count(deviceName) == 0 ) {
       std::map< unsigned int, isa::OpenCL::transposeConf > container;
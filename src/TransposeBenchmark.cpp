@@ -0,0 +1,484 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <exception>
+#include <stdexcept>
+#include <iomanip>
+#include <algorithm>
+#include <sstream>
+#include <thread>
+#include <functional>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+
+#include <ArgumentList.hpp>
+#include <InitializeOpenCL.hpp>
+#include <Kernel.hpp>
+#include <utils.hpp>
+#include <Timer.hpp>
+#include <Transpose.hpp>
+#include <TransposeFixed.hpp>
+#include <KernelCache.hpp>
+#include <TransposeSelector.hpp>
+
+// One back end on one shape, type and padding
+struct benchmarkResult {
+  std::string backend;
+  std::string device;
+  std::string type;
+  unsigned int M;
+  unsigned int N;
+  unsigned int padding;
+  // Average time in seconds and GB/s of M x N elements read and written
+  double time;
+  double GBs;
+  // Copy bandwidth of the same number of bytes on the same device, in GB/s
+  double rooflineGBs;
+  bool correct;
+};
+
+// The OpenCL device under test
+struct benchmarkDevice {
+  bool enabled;
+  std::string name;
+  unsigned int vector;
+  cl::Context clContext;
+  cl::Device clDevice;
+  cl::CommandQueue clQueue;
+  isa::OpenCL::transposeConf conf;
+  isa::OpenCL::transposeSelector selector;
+};
+
+// Parse "MxN,MxN,..."
+std::vector< std::pair< unsigned int, unsigned int > > readShapes(const std::string & shapes);
+// Parse "padding,padding,..."
+std::vector< unsigned int > readPaddings(const std::string & paddings);
+// Parse "type,type,..."
+std::vector< std::string > readTypes(const std::string & types);
+// All back ends on one shape and padding for type T
+template< typename T > void benchmarkType(const std::string & typeName, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int nrIterations, const unsigned int cpuTile, const unsigned int cpuThreads, benchmarkDevice & device, isa::OpenCL::kernelCache & cache, std::vector< benchmarkResult > & results);
+// Compare the N output rows of the M x N transpose, skipping the padding that no back end writes
+template< typename T > bool sameTranspose(const unsigned int M, const unsigned int N, const unsigned int padding, const std::vector< T > & output, const std::vector< T > & output_c);
+// Bandwidth of a multithreaded memcpy of nrBytes, in GB/s of bytes read and written
+double measureMemcpy(const std::size_t nrBytes, unsigned int nrThreads, const unsigned int nrIterations);
+// Bandwidth of a device copy kernel of nrElements elements, in GB/s of bytes read and written
+double measureDeviceCopy(benchmarkDevice & device, const std::string & typeName, const std::size_t typeSize, cl::Buffer & input_d, cl::Buffer & output_d, const unsigned int nrElements, const unsigned int nrIterations);
+// Device time in seconds of the last kernel
+double getKernelTime(cl::Event & event);
+void printText(const std::vector< benchmarkResult > & results);
+void printCSV(const std::vector< benchmarkResult > & results);
+void printJSON(const std::vector< benchmarkResult > & results);
+std::string escapeJSON(const std::string & text);
+
+int main(int argc, char * argv[]) {
+  bool csv = false;
+  bool json = false;
+  unsigned int nrIterations = 0;
+  unsigned int clPlatformID = 0;
+  unsigned int clDeviceID = 0;
+  unsigned int cpuTile = 0;
+  unsigned int cpuThreads = 0;
+  // Powers of two alias in the caches, odd sizes leave partial tiles
+  std::vector< std::pair< unsigned int, unsigned int > > shapes = readShapes("256x256,1024x1024,2048x2048,4096x4096,1024x16384,16384x1024,1000x1000,1023x1025,3001x2999,999x16383");
+  std::vector< unsigned int > paddings = readPaddings("1,32");
+  std::vector< std::string > types = readTypes("float,double,uchar");
+  std::string selectorFilename;
+  benchmarkDevice device;
+
+  device.enabled = false;
+  try {
+    isa::utils::ArgumentList args(argc, argv);
+    csv = args.getSwitch("-csv");
+    json = args.getSwitch("-json");
+    if ( args.getSwitch("-sweep") ) {
+      shapes = readShapes(args.getSwitchArgument< std::string >("-shapes"));
+      paddings = readPaddings(args.getSwitchArgument< std::string >("-paddings"));
+      types = readTypes(args.getSwitchArgument< std::string >("-types"));
+    }
+    device.enabled = args.getSwitch("-opencl");
+    if ( device.enabled ) {
+      if ( args.getSwitch("-selector") ) {
+        selectorFilename = args.getSwitchArgument< std::string >("-selector_file");
+      }
+      clPlatformID = args.getSwitchArgument< unsigned int >("-opencl_platform");
+      clDeviceID = args.getSwitchArgument< unsigned int >("-opencl_device");
+      device.vector = args.getSwitchArgument< unsigned int >("-vector");
+      device.conf.setTileWidth(args.getSwitchArgument< unsigned int >("-width"));
+      device.conf.setTileHeight(args.getSwitchArgument< unsigned int >("-height"));
+      device.conf.setNrItemsPerThread(args.getSwitchArgument< unsigned int >("-items"));
+      device.conf.setLocalPadding(args.getSwitchArgument< unsigned int >("-local_padding"));
+      device.conf.setVectorWidth(args.getSwitchArgument< unsigned int >("-vector_width"));
+      device.conf.setDirectWrite(args.getSwitchArgument< unsigned int >("-direct_write"));
+      device.conf.setDiagonal(args.getSwitchArgument< unsigned int >("-diagonal"));
+    }
+    nrIterations = args.getSwitchArgument< unsigned int >("-iterations");
+    cpuTile = args.getSwitchArgument< unsigned int >("-cpu_tile");
+    cpuThreads = args.getSwitchArgument< unsigned int >("-cpu_threads");
+  } catch ( isa::utils::EmptyCommandLine & err ) {
+    std::cerr << argv[0] << " [-csv | -json] [-sweep -shapes ... -paddings ... -types ...] [-opencl [-selector -selector_file ...] -opencl_platform ... -opencl_device ... -vector ... -width ... -height ... -items ... -local_padding ... -vector_width ... -direct_write ... -diagonal ...] -iterations ... -cpu_tile ... -cpu_threads ..." << std::endl;
+    std::cerr << "Shapes are MxN separated by commas, types are float, double and uchar; with -selector the OpenCL configuration is the one tuned for the shape, the command line is the fallback." << std::endl;
+    return 1;
+  } catch ( std::exception & err ) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  isa::OpenCL::kernelCache cache("");
+
+  if ( device.enabled ) {
+    std::vector< cl::Platform > * clPlatforms = new std::vector< cl::Platform >();
+    std::vector< cl::Device > * clDevices = new std::vector< cl::Device >();
+    std::vector< std::vector< cl::CommandQueue > > * clQueues = new std::vector< std::vector < cl::CommandQueue > >();
+
+    try {
+      isa::OpenCL::initializeOpenCL(clPlatformID, 1, clPlatforms, &(device.clContext), clDevices, clQueues);
+      device.clDevice = clDevices->at(clDeviceID);
+      device.name = device.clDevice.getInfo< CL_DEVICE_NAME >();
+      // Device times come from the profiling events
+      device.clQueue = cl::CommandQueue(device.clContext, device.clDevice, CL_QUEUE_PROFILING_ENABLE);
+    } catch ( cl::Error & err ) {
+      std::cerr << "OpenCL error: " << isa::utils::toString(err.err()) << "." << std::endl;
+      return 1;
+    }
+    if ( ! selectorFilename.empty() ) {
+      try {
+        device.selector.read(selectorFilename);
+      } catch ( std::runtime_error & err ) {
+        std::cerr << err.what() << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  std::vector< benchmarkResult > results;
+
+  srand(time(0));
+  for ( std::vector< std::string >::const_iterator type = types.begin(); type != types.end(); ++type ) {
+    for ( std::vector< std::pair< unsigned int, unsigned int > >::const_iterator shape = shapes.begin(); shape != shapes.end(); ++shape ) {
+      for ( std::vector< unsigned int >::const_iterator padding = paddings.begin(); padding != paddings.end(); ++padding ) {
+        try {
+          if ( *type == "float" ) {
+            benchmarkType< float >(*type, shape->first, shape->second, *padding, nrIterations, cpuTile, cpuThreads, device, cache, results);
+          } else if ( *type == "double" ) {
+            benchmarkType< double >(*type, shape->first, shape->second, *padding, nrIterations, cpuTile, cpuThreads, device, cache, results);
+          } else {
+            benchmarkType< unsigned char >(*type, shape->first, shape->second, *padding, nrIterations, cpuTile, cpuThreads, device, cache, results);
+          }
+        } catch ( isa::OpenCL::OpenCLError & err ) {
+          std::cerr << err.what() << std::endl;
+          return 1;
+        } catch ( cl::Error & err ) {
+          std::cerr << "OpenCL error: " << isa::utils::toString(err.err()) << "." << std::endl;
+          return 1;
+        }
+      }
+    }
+  }
+
+  if ( json ) {
+    printJSON(results);
+  } else if ( csv ) {
+    printCSV(results);
+  } else {
+    printText(results);
+  }
+  for ( std::vector< benchmarkResult >::const_iterator result = results.begin(); result != results.end(); ++result ) {
+    if ( ! result->correct ) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+std::vector< std::pair< unsigned int, unsigned int > > readShapes(const std::string & shapes) {
+  std::vector< std::pair< unsigned int, unsigned int > > list;
+  std::istringstream stream(shapes);
+  std::string shape;
+
+  while ( std::getline(stream, shape, ',') ) {
+    std::string::size_type splitPoint = shape.find("x");
+
+    if ( splitPoint == std::string::npos ) {
+      throw std::invalid_argument("Shapes are MxN, not " + shape + ".");
+    }
+    list.push_back(std::make_pair(isa::utils::castToType< std::string, unsigned int >(shape.substr(0, splitPoint)), isa::utils::castToType< std::string, unsigned int >(shape.substr(splitPoint + 1))));
+  }
+  return list;
+}
+
+std::vector< unsigned int > readPaddings(const std::string & paddings) {
+  std::vector< unsigned int > list;
+  std::istringstream stream(paddings);
+  std::string padding;
+
+  while ( std::getline(stream, padding, ',') ) {
+    list.push_back(isa::utils::castToType< std::string, unsigned int >(padding));
+  }
+  return list;
+}
+
+std::vector< std::string > readTypes(const std::string & types) {
+  std::vector< std::string > list;
+  std::istringstream stream(types);
+  std::string type;
+
+  while ( std::getline(stream, type, ',') ) {
+    if ( type != "float" && type != "double" && type != "uchar" ) {
+      throw std::invalid_argument("Type " + type + " is not supported.");
+    }
+    list.push_back(type);
+  }
+  return list;
+}
+
+template< typename T > void benchmarkType(const std::string & typeName, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int nrIterations, const unsigned int cpuTile, const unsigned int cpuThreads, benchmarkDevice & device, isa::OpenCL::kernelCache & cache, std::vector< benchmarkResult > & results) {
+  const long long unsigned int nrElements = static_cast< long long unsigned int >(M) * N;
+  const double gb = isa::utils::giga(nrElements * 2 * sizeof(T));
+  std::vector< T > input(M * isa::utils::pad(N, padding));
+  std::vector< T > output(N * isa::utils::pad(M, padding));
+  std::vector< T > output_c(N * isa::utils::pad(M, padding));
+  benchmarkResult result;
+
+  for ( typename std::vector< T >::iterator item = input.begin(); item != input.end(); ++item ) {
+    *item = static_cast< T >(rand() % 10);
+  }
+  isa::OpenCL::transpose(M, N, padding, input, output_c);
+
+  result.type = typeName;
+  result.M = M;
+  result.N = N;
+  result.padding = padding;
+  // Host back ends
+  const double hostRoofline = measureMemcpy(nrElements * sizeof(T), cpuThreads, nrIterations);
+  auto measureHost = [&](const std::string & backend, std::function< void() > run) {
+    isa::utils::Timer timer;
+
+    // Warm-up run, also checking the output
+    std::fill(output.begin(), output.end(), static_cast< T >(0));
+    run();
+    for ( unsigned int iteration = 0; iteration < nrIterations; iteration++ ) {
+      timer.start();
+      run();
+      timer.stop();
+    }
+    result.backend = backend;
+    result.device = "host";
+    result.time = timer.getAverageTime();
+    result.GBs = gb / result.time;
+    result.rooflineGBs = hostRoofline;
+    result.correct = sameTranspose(M, N, padding, output, output_c);
+    results.push_back(result);
+  };
+
+  measureHost("host_naive", [&]() {
+    isa::OpenCL::transpose(M, N, padding, input, output);
+  });
+  measureHost("host_tiled", [&]() {
+    isa::OpenCL::transpose(M, N, padding, input, output, cpuTile, cpuThreads);
+  });
+  measureHost("host_recursive", [&]() {
+    isa::OpenCL::transposeRecursive(M, N, padding, input, output, cpuThreads);
+  });
+  if ( isa::OpenCL::findFixedTranspose< T >(M, N, padding) != 0 ) {
+    measureHost("host_fixed", [&]() {
+      isa::OpenCL::transposeDispatch(M, N, padding, input, output, cpuTile, cpuThreads);
+    });
+  }
+  // OpenCL back end
+  if ( ! device.enabled ) {
+    return;
+  }
+  if ( typeName == "double" && device.clDevice.getInfo< CL_DEVICE_EXTENSIONS >().find("cl_khr_fp64") == std::string::npos ) {
+    return;
+  }
+  isa::OpenCL::transposeConf conf = device.conf;
+
+  try {
+    conf = device.selector.select(device.name, typeName, M, N, padding);
+  } catch ( std::out_of_range & err ) {
+    // Not tuned, use the configuration from the command line
+  }
+  // Odd shapes can not be accessed with vectors
+  if ( (isa::utils::pad(N, padding) % conf.getVectorWidth()) != 0 || (isa::utils::pad(M, padding) % conf.getVectorWidth()) != 0 ) {
+    conf.setVectorWidth(1);
+  }
+  const std::string configuration = isa::utils::toString(M) + " " + isa::utils::toString(N) + " " + isa::utils::toString(padding) + " " + isa::utils::toString(device.vector) + " " + typeName + " " + conf.print();
+  auto generator = [&]() {
+    return isa::OpenCL::getTransposeOpenCL(conf, M, N, padding, device.vector, typeName);
+  };
+  cl::Kernel * kernel = cache.getKernel("transpose", configuration, generator, "-cl-mad-enable -Werror", device.clContext, device.clDevice);
+  cl::Buffer input_d(device.clContext, CL_MEM_READ_ONLY, input.size() * sizeof(T), 0, 0);
+  cl::Buffer output_d(device.clContext, CL_MEM_READ_WRITE, output.size() * sizeof(T), 0, 0);
+  cl::NDRange global(std::ceil(static_cast< double >(M) / conf.getTileHeight()) * conf.getNrThreads(), std::ceil(static_cast< double >(N) / conf.getTileWidth()));
+  cl::NDRange local(conf.getNrThreads(), 1);
+  cl::Event event;
+  double totalTime = 0.0;
+
+  device.clQueue.enqueueWriteBuffer(input_d, CL_TRUE, 0, input.size() * sizeof(T), reinterpret_cast< void * >(input.data()));
+  kernel->setArg(0, input_d);
+  kernel->setArg(1, output_d);
+  // Warm-up run, also checking the output
+  device.clQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, &event);
+  event.wait();
+  std::fill(output.begin(), output.end(), static_cast< T >(0));
+  device.clQueue.enqueueReadBuffer(output_d, CL_TRUE, 0, output.size() * sizeof(T), reinterpret_cast< void * >(output.data()));
+  for ( unsigned int iteration = 0; iteration < nrIterations; iteration++ ) {
+    device.clQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, &event);
+    event.wait();
+    totalTime += getKernelTime(event);
+  }
+  delete kernel;
+  result.backend = "opencl";
+  result.device = device.name;
+  result.time = totalTime / std::max(nrIterations, 1u);
+  result.GBs = gb / result.time;
+  result.rooflineGBs = measureDeviceCopy(device, typeName, sizeof(T), input_d, output_d, nrElements, nrIterations);
+  result.correct = sameTranspose(M, N, padding, output, output_c);
+  results.push_back(result);
+}
+
+template< typename T > bool sameTranspose(const unsigned int M, const unsigned int N, const unsigned int padding, const std::vector< T > & output, const std::vector< T > & output_c) {
+  for ( unsigned int n = 0; n < N; n++ ) {
+    const long long unsigned int row = static_cast< long long unsigned int >(n) * isa::utils::pad(M, padding);
+
+    if ( ! std::equal(output.begin() + row, output.begin() + row + M, output_c.begin() + row) ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+double measureMemcpy(const std::size_t nrBytes, unsigned int nrThreads, const unsigned int nrIterations) {
+  std::vector< char > source(nrBytes, 1);
+  std::vector< char > destination(nrBytes, 0);
+  isa::utils::Timer timer;
+
+  if ( nrThreads == 0 ) {
+    nrThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  // Every thread copies a contiguous chunk, as the STREAM copy kernel does
+  auto copy = [&]() {
+    const std::size_t chunk = (nrBytes + nrThreads - 1) / nrThreads;
+    std::vector< std::thread > pool;
+    auto copyChunk = [&](const unsigned int thread) {
+      const std::size_t begin = std::min(thread * chunk, nrBytes);
+
+      std::memcpy(destination.data() + begin, source.data() + begin, std::min(chunk, nrBytes - begin));
+    };
+
+    for ( unsigned int thread = 1; thread < nrThreads; thread++ ) {
+      pool.push_back(std::thread(copyChunk, thread));
+    }
+    copyChunk(0);
+    for ( std::vector< std::thread >::iterator thread = pool.begin(); thread != pool.end(); ++thread ) {
+      thread->join();
+    }
+  };
+
+  copy();
+  for ( unsigned int iteration = 0; iteration < nrIterations; iteration++ ) {
+    timer.start();
+    copy();
+    timer.stop();
+  }
+  return isa::utils::giga(static_cast< long long unsigned int >(nrBytes) * 2) / timer.getAverageTime();
+}
+
+double measureDeviceCopy(benchmarkDevice & device, const std::string & typeName, const std::size_t typeSize, cl::Buffer & input_d, cl::Buffer & output_d, const unsigned int nrElements, const unsigned int nrIterations) {
+  std::string * code = isa::OpenCL::getCopyOpenCL(nrElements, typeName);
+  cl::Kernel * kernel = isa::OpenCL::compile("copy", *code, "-cl-mad-enable -Werror", device.clContext, device.clDevice);
+  cl::NDRange global(isa::utils::pad(nrElements, 256));
+  cl::NDRange local(256);
+  cl::Event event;
+  double totalTime = 0.0;
+
+  delete code;
+  kernel->setArg(0, input_d);
+  kernel->setArg(1, output_d);
+  // Warm-up run
+  device.clQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, &event);
+  event.wait();
+  for ( unsigned int iteration = 0; iteration < nrIterations; iteration++ ) {
+    device.clQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, &event);
+    event.wait();
+    totalTime += getKernelTime(event);
+  }
+  delete kernel;
+
+  return isa::utils::giga(static_cast< long long unsigned int >(nrElements) * 2 * typeSize) / (totalTime / std::max(nrIterations, 1u));
+}
+
+double getKernelTime(cl::Event & event) {
+  return (event.getProfilingInfo< CL_PROFILING_COMMAND_END >() - event.getProfilingInfo< CL_PROFILING_COMMAND_START >()) * 1.0e-09;
+}
+
+void printText(const std::vector< benchmarkResult > & results) {
+  std::cout << std::fixed << std::endl;
+  std::cout << "# backend type M N padding time GB/s rooflineGB/s roofline% correct" << std::endl;
+  std::cout << "# GB/s counts M x N elements read and written, the roofline is a copy of as many bytes on the same device" << std::endl << std::endl;
+  for ( std::vector< benchmarkResult >::const_iterator result = results.begin(); result != results.end(); ++result ) {
+    std::cout << result->backend << " " << result->type << " " << result->M << " " << result->N << " " << result->padding << " ";
+    std::cout << std::setprecision(6) << result->time << " ";
+    std::cout << std::setprecision(3) << result->GBs << " " << result->rooflineGBs << " " << (result->GBs * 100.0) / result->rooflineGBs << " ";
+    std::cout << (result->correct ? "yes" : "no") << std::endl;
+  }
+  std::cout << std::endl;
+}
+
+void printCSV(const std::vector< benchmarkResult > & results) {
+  std::cout << std::fixed;
+  std::cout << "backend,device,type,M,N,padding,time,GBs,rooflineGBs,rooflinePercentage,correct" << std::endl;
+  for ( std::vector< benchmarkResult >::const_iterator result = results.begin(); result != results.end(); ++result ) {
+    std::cout << result->backend << ",\"" << result->device << "\"," << result->type << "," << result->M << "," << result->N << "," << result->padding << ",";
+    std::cout << std::setprecision(9) << result->time << ",";
+    std::cout << std::setprecision(3) << result->GBs << "," << result->rooflineGBs << "," << (result->GBs * 100.0) / result->rooflineGBs << ",";
+    std::cout << (result->correct ? 1 : 0) << std::endl;
+  }
+}
+
+void printJSON(const std::vector< benchmarkResult > & results) {
+  std::cout << std::fixed;
+  std::cout << "{" << std::endl;
+  std::cout << "  \"results\": [" << std::endl;
+  for ( std::vector< benchmarkResult >::const_iterator result = results.begin(); result != results.end(); ++result ) {
+    std::cout << "    {\"backend\": \"" << result->backend << "\", \"device\": \"" << escapeJSON(result->device) << "\", \"type\": \"" << result->type << "\", ";
+    std::cout << "\"M\": " << result->M << ", \"N\": " << result->N << ", \"padding\": " << result->padding << ", ";
+    std::cout << std::setprecision(9) << "\"time\": " << result->time << ", ";
+    std::cout << std::setprecision(3) << "\"GBs\": " << result->GBs << ", \"rooflineGBs\": " << result->rooflineGBs << ", \"rooflinePercentage\": " << (result->GBs * 100.0) / result->rooflineGBs << ", ";
+    std::cout << "\"correct\": " << (result->correct ? "true" : "false") << "}";
+    if ( result + 1 != results.end() ) {
+      std::cout << ",";
+    }
+    std::cout << std::endl;
+  }
+  std::cout << "  ]" << std::endl;
+  std::cout << "}" << std::endl;
+}
+
+std::string escapeJSON(const std::string & text) {
+  std::string escaped;
+
+  for ( std::string::const_iterator character = text.begin(); character != text.end(); ++character ) {
+    if ( *character == '"' || *character == '\\' ) {
+      escaped += '\\';
+    }
+    escaped += *character;
+  }
+  return escaped;
+}
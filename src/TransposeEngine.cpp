@@ -0,0 +1,177 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+
+#include <TransposeEngine.hpp>
+
+namespace isa {
+namespace OpenCL {
+
+std::size_t getPoolBucket(const std::size_t size) {
+  std::size_t bucket = 4096;
+
+  while ( bucket < size ) {
+    bucket *= 2;
+  }
+  return bucket;
+}
+
+transposeEngine::transposeEngine(const unsigned int clPlatformID, const unsigned int clDeviceID, const unsigned int nrQueues, const unsigned int vector, const std::string & cacheDirectory) : clDeviceID(clDeviceID), vector(vector), nextQueue(0), cache(cacheDirectory), poolSize(0), nrInFlight(0) {
+  isa::OpenCL::initializeOpenCL(clPlatformID, nrQueues, &clPlatforms, &clContext, &clDevices, &clQueues);
+}
+
+transposeEngine::~transposeEngine() {
+  std::unique_lock< std::mutex > lock(poolMutex);
+
+  idle.wait(lock, [this]() { return nrInFlight == 0; });
+  for ( std::map< std::string, cl::Kernel * >::iterator kernel = kernels.begin(); kernel != kernels.end(); ++kernel ) {
+    delete kernel->second;
+  }
+}
+
+std::size_t transposeEngine::getPoolSize() const {
+  std::lock_guard< std::mutex > lock(poolMutex);
+
+  return poolSize;
+}
+
+cl::Kernel * transposeEngine::getKernel(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const std::string & typeName) {
+  const std::string configuration = isa::utils::toString(M) + " " + isa::utils::toString(N) + " " + isa::utils::toString(padding) + " " + isa::utils::toString(vector) + " " + typeName + " " + conf.print();
+  std::map< std::string, cl::Kernel * >::iterator kernel = kernels.find(configuration);
+
+  if ( kernel != kernels.end() ) {
+    return kernel->second;
+  }
+  auto generator = [&]() {
+    return isa::OpenCL::getTransposeOpenCL(conf, M, N, padding, vector, typeName);
+  };
+  cl::Kernel * compiled = cache.getKernel("transpose", configuration, generator, "-cl-mad-enable -Werror", clContext, clDevices.at(clDeviceID));
+
+  kernels.insert(std::make_pair(configuration, compiled));
+  return compiled;
+}
+
+cl::Buffer transposeEngine::acquireBuffer(const std::size_t size) {
+  const std::size_t bucket = getPoolBucket(size);
+  std::lock_guard< std::mutex > lock(poolMutex);
+  std::vector< cl::Buffer > & buffers = pool[bucket];
+
+  if ( buffers.size() > 0 ) {
+    cl::Buffer buffer = buffers.back();
+
+    buffers.pop_back();
+    return buffer;
+  }
+  poolSize += bucket;
+  return cl::Buffer(clContext, CL_MEM_READ_WRITE, bucket, 0, 0);
+}
+
+void transposeEngine::releaseBuffer(const std::size_t size, const cl::Buffer & buffer) {
+  std::lock_guard< std::mutex > lock(poolMutex);
+
+  pool[getPoolBucket(size)].push_back(buffer);
+}
+
+std::future< void > transposeEngine::submit(const transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const std::string & typeName, const std::size_t typeSize, const void * input, void * output) {
+  std::lock_guard< std::mutex > lock(submitMutex);
+  const std::size_t inputSize = M * isa::utils::pad(N, padding) * typeSize;
+  const std::size_t outputSize = N * isa::utils::pad(M, padding) * typeSize;
+  cl::Kernel * kernel = getKernel(conf, M, N, padding, typeName);
+  cl::CommandQueue & clQueue = clQueues.at(clDeviceID).at(nextQueue);
+  cl::NDRange global(std::ceil(static_cast< double >(M) / conf.getTileHeight()) * conf.getNrThreads(), std::ceil(static_cast< double >(N) / conf.getTileWidth()));
+  cl::NDRange local(conf.getNrThreads(), 1);
+  cl::Buffer input_d = acquireBuffer(inputSize);
+  cl::Buffer output_d = acquireBuffer(outputSize);
+  request * inFlight = new request();
+  std::future< void > done = inFlight->done.get_future();
+  cl::size_t< 3 > origin;
+  cl::size_t< 3 > region;
+  cl::Event event;
+
+  origin[0] = 0;
+  origin[1] = 0;
+  origin[2] = 0;
+  region[0] = M * typeSize;
+  region[1] = N;
+  region[2] = 1;
+  inFlight->engine = this;
+  inFlight->input_d = input_d;
+  inFlight->output_d = output_d;
+  inFlight->inputSize = inputSize;
+  inFlight->outputSize = outputSize;
+  nextQueue = (nextQueue + 1) % clQueues.at(clDeviceID).size();
+  try {
+    clQueue.enqueueWriteBuffer(inFlight->input_d, CL_FALSE, 0, inputSize, input);
+    // The arguments are captured by the enqueue, so the kernel can be reused right away
+    kernel->setArg(0, inFlight->input_d);
+    kernel->setArg(1, inFlight->output_d);
+    clQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local);
+    // Only the M columns the kernel writes, the padding of the pooled buffer may hold the data of other requests
+    clQueue.enqueueReadBufferRect(inFlight->output_d, CL_FALSE, origin, origin, region, isa::utils::pad(M, padding) * typeSize, 0, isa::utils::pad(M, padding) * typeSize, 0, output, 0, &event);
+  } catch ( cl::Error & err ) {
+    releaseBuffer(inputSize, inFlight->input_d);
+    releaseBuffer(outputSize, inFlight->output_d);
+    delete inFlight;
+    throw;
+  }
+  {
+    std::lock_guard< std::mutex > poolLock(poolMutex);
+
+    nrInFlight++;
+  }
+  // The buffers go back to the pool only when the output has been read
+  try {
+    event.setCallback(CL_COMPLETE, &transposeEngine::completeRequest, reinterpret_cast< void * >(inFlight));
+  } catch ( cl::Error & err ) {
+    // Without a callback nobody would complete the request, so wait for it here
+    cl_int status = CL_COMPLETE;
+
+    try {
+      event.wait();
+    } catch ( cl::Error & waitErr ) {
+      status = waitErr.err();
+    }
+    completeRequest(0, status, reinterpret_cast< void * >(inFlight));
+    return done;
+  }
+  clQueue.flush();
+  return done;
+}
+
+void CL_CALLBACK transposeEngine::completeRequest(cl_event event, cl_int status, void * data) {
+  request * inFlight = reinterpret_cast< request * >(data);
+  transposeEngine * engine = inFlight->engine;
+
+  (void)event;
+  engine->releaseBuffer(inFlight->inputSize, inFlight->input_d);
+  engine->releaseBuffer(inFlight->outputSize, inFlight->output_d);
+  // A negative status is the error that terminated the commands
+  if ( status < 0 ) {
+    inFlight->done.set_exception(std::make_exception_ptr(isa::OpenCL::OpenCLError("The transpose failed: " + isa::utils::toString(status) + ".")));
+  } else {
+    inFlight->done.set_value();
+  }
+  delete inFlight;
+  // The engine may be destroyed as soon as the last request is not in flight anymore
+  {
+    std::lock_guard< std::mutex > poolLock(engine->poolMutex);
+
+    engine->nrInFlight--;
+    engine->idle.notify_all();
+  }
+}
+
+} // OpenCL
+} // isa
@@ -0,0 +1,171 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <exception>
+#include <stdexcept>
+#include <iomanip>
+#include <cmath>
+
+#include <ArgumentList.hpp>
+#include <InitializeOpenCL.hpp>
+#include <Kernel.hpp>
+#include <utils.hpp>
+#include <Timer.hpp>
+#include <Transpose.hpp>
+#include <TransposeStream.hpp>
+
+typedef float dataType;
+std::string typeName("float");
+
+
+int main(int argc, char *argv[]) {
+  bool useOpenCL = false;
+  bool cpuRecursive = false;
+  unsigned int clPlatformID = 0;
+  unsigned int clDeviceID = 0;
+  unsigned int padding = 0;
+  unsigned int vector = 0;
+  unsigned int cpuTile = 0;
+  unsigned int cpuThreads = 0;
+  unsigned int M = 0;
+  unsigned int N = 0;
+  unsigned int panelRows = 0;
+  std::size_t memoryBudget = 0;
+  std::string inputFilename;
+  std::string outputFilename;
+  isa::OpenCL::transposeConf conf;
+  isa::OpenCL::panelTranspose< dataType > kernel;
+  isa::utils::Timer timer;
+
+  try {
+    isa::utils::ArgumentList args(argc, argv);
+    useOpenCL = args.getSwitch("-opencl");
+    if ( useOpenCL ) {
+      clPlatformID = args.getSwitchArgument< unsigned int >("-opencl_platform");
+      clDeviceID = args.getSwitchArgument< unsigned int >("-opencl_device");
+      vector = args.getSwitchArgument< unsigned int >("-vector");
+      conf.setTileWidth(args.getSwitchArgument< unsigned int >("-width"));
+      conf.setTileHeight(args.getSwitchArgument< unsigned int >("-height"));
+      conf.setNrItemsPerThread(args.getSwitchArgument< unsigned int >("-items"));
+      conf.setLocalPadding(args.getSwitchArgument< unsigned int >("-local_padding"));
+      conf.setVectorWidth(args.getSwitchArgument< unsigned int >("-vector_width"));
+      conf.setDirectWrite(args.getSwitchArgument< unsigned int >("-direct_write"));
+      conf.setDiagonal(args.getSwitchArgument< unsigned int >("-diagonal"));
+    } else {
+      cpuRecursive = args.getSwitch("-cpu_recursive");
+      if ( ! cpuRecursive ) {
+        cpuTile = args.getSwitchArgument< unsigned int >("-cpu_tile");
+      }
+      cpuThreads = args.getSwitchArgument< unsigned int >("-cpu_threads");
+    }
+    inputFilename = args.getSwitchArgument< std::string >("-input");
+    outputFilename = args.getSwitchArgument< std::string >("-output");
+    padding = args.getSwitchArgument< unsigned int >("-padding");
+    memoryBudget = args.getSwitchArgument< std::size_t >("-budget") * 1024 * 1024;
+    M = args.getSwitchArgument< unsigned int >("-M");
+    N = args.getSwitchArgument< unsigned int >("-N");
+    if ( useOpenCL && ((conf.getTileWidth() == 0) || (conf.getTileHeight() == 0)) ) {
+      throw std::invalid_argument("The tile can not be empty.");
+    }
+  } catch  ( isa::utils::SwitchNotFound & err ) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  } catch ( std::exception & err ) {
+    std::cerr << "Usage: " << argv[0] << " [-opencl -opencl_platform ... -opencl_device ... -vector ... -width ... -height ... -items ... -local_padding ... -vector_width ... -direct_write ... -diagonal ...] [[-cpu_recursive | -cpu_tile ...] -cpu_threads ...] -input ... -output ... -padding ... -budget ... (MB) -M ... -N ..." << std::endl;
+    return 1;
+  }
+
+  // OpenCL state, only used if the panels are transposed on the device
+  cl::Context * clContext = new cl::Context();
+  std::vector< cl::Platform > * clPlatforms = new std::vector< cl::Platform >();
+  std::vector< cl::Device > * clDevices = new std::vector< cl::Device >();
+  std::vector< std::vector< cl::CommandQueue > > * clQueues = new std::vector< std::vector < cl::CommandQueue > >();
+  cl::Kernel * clKernel = 0;
+  cl::Buffer input_d;
+  cl::Buffer output_d;
+
+  if ( useOpenCL ) {
+    // Device buffers are sized for a panel, the kernel always transposes a full panel
+    panelRows = isa::OpenCL::getTransposePanelRows(M, N, padding, sizeof(dataType), memoryBudget, conf.getTileHeight());
+    isa::OpenCL::initializeOpenCL(clPlatformID, 1, clPlatforms, clContext, clDevices, clQueues);
+    try {
+      input_d = cl::Buffer(*clContext, CL_MEM_READ_ONLY, panelRows * isa::utils::pad(N, padding) * sizeof(dataType), 0, 0);
+      output_d = cl::Buffer(*clContext, CL_MEM_WRITE_ONLY, N * isa::utils::pad(panelRows, padding) * sizeof(dataType), 0, 0);
+    } catch ( cl::Error & err ) {
+      std::cerr << "OpenCL error allocating memory: " << isa::utils::toString< cl_int >(err.err()) << "." << std::endl;
+      return 1;
+    }
+    std::string * code = isa::OpenCL::getTransposeOpenCL(conf, panelRows, N, padding, vector, typeName);
+    try {
+      clKernel = isa::OpenCL::compile("transpose", *code, "-cl-mad-enable -Werror", *clContext, clDevices->at(clDeviceID));
+    } catch ( isa::OpenCL::OpenCLError & err ) {
+      std::cerr << err.what() << std::endl;
+      return 1;
+    }
+    delete code;
+    clKernel->setArg(0, input_d);
+    clKernel->setArg(1, output_d);
+
+    kernel = [&](const unsigned int firstRow, const unsigned int nrRows, const dataType * panel, dataType * output) {
+      cl::NDRange global(std::ceil(static_cast< double >(panelRows) / conf.getTileHeight()) * conf.getNrThreads(), std::ceil(static_cast< double >(N) / conf.getTileWidth()));
+      cl::NDRange local(conf.getNrThreads(), 1);
+      cl::size_t< 3 > bufferOrigin;
+      cl::size_t< 3 > hostOrigin;
+      cl::size_t< 3 > region;
+
+      bufferOrigin[0] = 0;
+      bufferOrigin[1] = 0;
+      bufferOrigin[2] = 0;
+      hostOrigin[0] = firstRow * sizeof(dataType);
+      hostOrigin[1] = 0;
+      hostOrigin[2] = 0;
+      region[0] = nrRows * sizeof(dataType);
+      region[1] = N;
+      region[2] = 1;
+      clQueues->at(clDeviceID)[0].enqueueWriteBuffer(input_d, CL_FALSE, 0, nrRows * isa::utils::pad(N, padding) * sizeof(dataType), reinterpret_cast< const void * >(panel));
+      clQueues->at(clDeviceID)[0].enqueueNDRangeKernel(*clKernel, cl::NullRange, global, local, 0, 0);
+      // The columns of the panel go straight to their place in the output file
+      clQueues->at(clDeviceID)[0].enqueueReadBufferRect(output_d, CL_TRUE, bufferOrigin, hostOrigin, region, isa::utils::pad(panelRows, padding) * sizeof(dataType), 0, isa::utils::pad(M, padding) * sizeof(dataType), 0, reinterpret_cast< void * >(output));
+    };
+  } else {
+    panelRows = isa::OpenCL::getTransposePanelRows(M, N, padding, sizeof(dataType), memoryBudget, 1);
+    kernel = isa::OpenCL::getHostPanelTranspose< dataType >(cpuRecursive ? isa::OpenCL::HOST_RECURSIVE : isa::OpenCL::HOST_TILED, M, N, padding, cpuTile, cpuThreads);
+  }
+
+  try {
+    timer.start();
+    isa::OpenCL::transposeFile(inputFilename, outputFilename, M, N, padding, panelRows, kernel);
+    timer.stop();
+  } catch ( cl::Error & err ) {
+    std::cerr << "OpenCL error: " << isa::utils::toString< cl_int >(err.err()) << "." << std::endl;
+    return 1;
+  } catch ( std::exception & err ) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+  delete clKernel;
+
+  std::cout << std::fixed;
+  std::cout << "# M N panelRows GB/s time" << std::endl;
+  std::cout << M << " " << N << " " << panelRows << " ";
+  std::cout << std::setprecision(3);
+  std::cout << isa::utils::giga(static_cast< long long unsigned int >(M) * N * 2 * sizeof(dataType)) / timer.getTotalTime() << " ";
+  std::cout << std::setprecision(6);
+  std::cout << timer.getTotalTime() << std::endl;
+
+  return 0;
+}
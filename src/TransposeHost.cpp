@@ -0,0 +1,130 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <exception>
+#include <iomanip>
+#include <algorithm>
+#include <ctime>
+
+#include <ArgumentList.hpp>
+#include <utils.hpp>
+#include <Timer.hpp>
+#include <Transpose.hpp>
+#include <TransposeFixed.hpp>
+
+typedef float dataType;
+std::string typeName("float");
+
+// Benchmark the generic tiled transpose against the specialization for the shape
+int benchmarkFixed(const isa::OpenCL::fixedTranspose< dataType > & fixed, const unsigned int nrIterations, const unsigned int cpuTile, const unsigned int cpuThreads);
+
+int main(int argc, char * argv[]) {
+  bool allShapes = false;
+  unsigned int nrIterations = 0;
+  unsigned int cpuTile = 0;
+  unsigned int cpuThreads = 0;
+  unsigned int padding = 0;
+  unsigned int M = 0;
+  unsigned int N = 0;
+
+  try {
+    isa::utils::ArgumentList args(argc, argv);
+    allShapes = args.getSwitch("-all");
+    nrIterations = args.getSwitchArgument< unsigned int >("-iterations");
+    cpuTile = args.getSwitchArgument< unsigned int >("-cpu_tile");
+    cpuThreads = args.getSwitchArgument< unsigned int >("-cpu_threads");
+    if ( ! allShapes ) {
+      padding = args.getSwitchArgument< unsigned int >("-padding");
+      M = args.getSwitchArgument< unsigned int >("-M");
+      N = args.getSwitchArgument< unsigned int >("-N");
+    }
+  } catch ( isa::utils::EmptyCommandLine & err ) {
+    std::cerr << argv[0] << " [-all] -iterations ... -cpu_tile ... -cpu_threads ... [-padding ... -M ... -N ...]" << std::endl;
+    std::cerr << "With -all every specialized shape is measured, otherwise only the one given." << std::endl;
+    return 1;
+  } catch ( std::exception & err ) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  const std::vector< isa::OpenCL::fixedTranspose< dataType > > & table = isa::OpenCL::getFixedTransposes< dataType >();
+
+  srand(time(0));
+  std::cout << std::fixed << std::endl;
+  std::cout << "# M N padding genericTile fixedTile generic[GB/s] fixed[GB/s] speedup" << std::endl << std::endl;
+  if ( allShapes ) {
+    for ( std::vector< isa::OpenCL::fixedTranspose< dataType > >::const_iterator fixed = table.begin(); fixed != table.end(); ++fixed ) {
+      if ( benchmarkFixed(*fixed, nrIterations, cpuTile, cpuThreads) != 0 ) {
+        return 1;
+      }
+    }
+  } else {
+    const isa::OpenCL::fixedTranspose< dataType > * fixed = isa::OpenCL::findFixedTranspose< dataType >(M, N, padding);
+
+    if ( fixed == 0 ) {
+      std::cerr << "There is no specialization for " << M << " x " << N << " with padding " << padding << "." << std::endl;
+      return 1;
+    }
+    if ( benchmarkFixed(*fixed, nrIterations, cpuTile, cpuThreads) != 0 ) {
+      return 1;
+    }
+  }
+  std::cout << std::endl;
+
+  return 0;
+}
+
+int benchmarkFixed(const isa::OpenCL::fixedTranspose< dataType > & fixed, const unsigned int nrIterations, const unsigned int cpuTile, const unsigned int cpuThreads) {
+  const double gbs = isa::utils::giga(static_cast< long long unsigned int >(fixed.M) * fixed.N * 2 * sizeof(dataType));
+  std::vector< dataType > input(fixed.M * isa::utils::pad(fixed.N, fixed.padding));
+  std::vector< dataType > output(fixed.N * isa::utils::pad(fixed.M, fixed.padding));
+  std::vector< dataType > output_c(fixed.N * isa::utils::pad(fixed.M, fixed.padding));
+  isa::utils::Timer genericTimer;
+  isa::utils::Timer fixedTimer;
+
+  for ( std::vector< dataType >::iterator item = input.begin(); item != input.end(); ++item ) {
+    *item = static_cast< dataType >(rand() % 10);
+  }
+  isa::OpenCL::transpose(fixed.M, fixed.N, fixed.padding, input, output_c);
+
+  // Warm-up runs, also checking the output
+  isa::OpenCL::transpose(fixed.M, fixed.N, fixed.padding, input, output, cpuTile, cpuThreads);
+  if ( ! std::equal(output.begin(), output.end(), output_c.begin()) ) {
+    std::cerr << "Wrong output of the generic transpose for " << fixed.M << " x " << fixed.N << "." << std::endl;
+    return 1;
+  }
+  std::fill(output.begin(), output.end(), static_cast< dataType >(0));
+  fixed.function(input.data(), output.data(), cpuThreads);
+  if ( ! std::equal(output.begin(), output.end(), output_c.begin()) ) {
+    std::cerr << "Wrong output of the specialized transpose for " << fixed.M << " x " << fixed.N << "." << std::endl;
+    return 1;
+  }
+  // Alternate the two versions, so that both see the same state of the machine
+  for ( unsigned int iteration = 0; iteration < nrIterations; iteration++ ) {
+    genericTimer.start();
+    isa::OpenCL::transpose(fixed.M, fixed.N, fixed.padding, input, output, cpuTile, cpuThreads);
+    genericTimer.stop();
+    fixedTimer.start();
+    fixed.function(input.data(), output.data(), cpuThreads);
+    fixedTimer.stop();
+  }
+  std::cout << fixed.M << " " << fixed.N << " " << fixed.padding << " " << cpuTile << " " << fixed.tile << " ";
+  std::cout << std::setprecision(3) << gbs / genericTimer.getAverageTime() << " " << gbs / fixedTimer.getAverageTime() << " ";
+  std::cout << std::setprecision(2) << genericTimer.getAverageTime() / fixedTimer.getAverageTime() << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,143 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <stdexcept>
+#include <unistd.h>
+
+#include <TransposePadding.hpp>
+
+namespace isa {
+namespace OpenCL {
+
+// Cache of the host when sysconf() does not know it
+static const unsigned int defaultLineSize = 64;
+static const unsigned int defaultCacheSize = 32 * 1024;
+static const unsigned int defaultAssociativity = 8;
+
+// A padding and what the model thinks of it
+struct paddingCandidate {
+  unsigned int padding;
+  unsigned int degree;
+  long long unsigned int size;
+};
+
+paddingModel::paddingModel(const unsigned int binSize, const unsigned int nrBins, const unsigned int associativity) : binSize(binSize), nrBins(nrBins), associativity(associativity) {
+  if ( (binSize == 0) || (nrBins == 0) || (associativity == 0) ) {
+    throw std::invalid_argument("The padding model needs bins, of some size, holding something.");
+  }
+}
+
+paddingModel::~paddingModel() {}
+
+unsigned int paddingModel::getConflictDegree(const std::size_t stride, const unsigned int nrRows) const {
+  std::vector< unsigned int > bins(nrBins, 0);
+  unsigned int mostRows = 0;
+
+  for ( unsigned int row = 0; row < nrRows; row++ ) {
+    unsigned int bin = ((row * stride) / binSize) % nrBins;
+
+    bins[bin]++;
+    mostRows = std::max(mostRows, bins[bin]);
+  }
+  return std::max((mostRows + associativity - 1) / associativity, 1u);
+}
+
+paddingModel getHostPaddingModel() {
+  long lineSize = -1;
+  long cacheSize = -1;
+  long associativity = -1;
+
+#ifdef _SC_LEVEL1_DCACHE_LINESIZE
+  lineSize = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+  cacheSize = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+  associativity = sysconf(_SC_LEVEL1_DCACHE_ASSOC);
+#endif
+  if ( (lineSize <= 0) || (cacheSize <= 0) || (associativity <= 0) || (cacheSize < lineSize * associativity) ) {
+    lineSize = defaultLineSize;
+    cacheSize = defaultCacheSize;
+    associativity = defaultAssociativity;
+  }
+  return paddingModel(lineSize, cacheSize / (lineSize * associativity), associativity);
+}
+
+paddingModel getDevicePaddingModel(const unsigned int partitionSize, const unsigned int nrPartitions) {
+  return paddingModel(partitionSize, nrPartitions, 1);
+}
+
+unsigned int getAdvisedLeadingDimension(const unsigned int columns, const std::size_t typeSize, const unsigned int alignment, const paddingModel & model) {
+  const unsigned int step = std::max(alignment, 1u);
+  // After a period the strides map to the same bins again, there is no point in padding more
+  const unsigned int lastLD = isa::utils::pad(columns, step) + std::max(static_cast< unsigned int >(model.getPeriod() / typeSize), step);
+  unsigned int bestLD = isa::utils::pad(columns, step);
+  unsigned int bestDegree = model.getConflictDegree(bestLD * typeSize, paddingModelRows);
+
+  for ( unsigned int leadingDimension = bestLD + step; (leadingDimension < lastLD) && (bestDegree > 1); leadingDimension += step ) {
+    unsigned int degree = model.getConflictDegree(leadingDimension * typeSize, paddingModelRows);
+
+    if ( degree < bestDegree ) {
+      bestLD = leadingDimension;
+      bestDegree = degree;
+    }
+  }
+  return bestLD;
+}
+
+std::vector< unsigned int > getPaddingCandidates(const unsigned int M, const unsigned int N, const std::size_t typeSize, const unsigned int alignment, const unsigned int nrCandidates, const paddingModel & model) {
+  const unsigned int step = std::max(alignment, 1u);
+  const unsigned int lastPadding = std::max(static_cast< unsigned int >(model.getPeriod() / typeSize), step);
+  std::vector< paddingCandidate > candidates;
+  std::vector< unsigned int > paddings;
+
+  for ( unsigned int padding = step; padding <= lastPadding; padding += step ) {
+    const unsigned int inputLD = isa::utils::pad(N, padding);
+    const unsigned int outputLD = isa::utils::pad(M, padding);
+    bool duplicate = false;
+
+    // Different paddings can give the same leading dimensions, keep the smallest
+    for ( std::vector< paddingCandidate >::const_iterator candidate = candidates.begin(); candidate != candidates.end(); ++candidate ) {
+      if ( (isa::utils::pad(N, candidate->padding) == inputLD) && (isa::utils::pad(M, candidate->padding) == outputLD) ) {
+        duplicate = true;
+        break;
+      }
+    }
+    if ( duplicate ) {
+      continue;
+    }
+    // The transpose reads columns of the input and writes columns of the output, both suffer from conflicts
+    paddingCandidate candidate;
+
+    candidate.padding = padding;
+    candidate.degree = model.getConflictDegree(static_cast< std::size_t >(inputLD) * typeSize, std::min(M, paddingModelRows)) + model.getConflictDegree(static_cast< std::size_t >(outputLD) * typeSize, std::min(N, paddingModelRows));
+    candidate.size = (static_cast< long long unsigned int >(M) * inputLD) + (static_cast< long long unsigned int >(N) * outputLD);
+    candidates.push_back(candidate);
+  }
+  std::stable_sort(candidates.begin(), candidates.end(), [](const paddingCandidate & left, const paddingCandidate & right) {
+    if ( left.degree != right.degree ) {
+      return left.degree < right.degree;
+    }
+    return left.size < right.size;
+  });
+  for ( unsigned int candidate = 0; (candidate < candidates.size()) && (candidate < nrCandidates); candidate++ ) {
+    paddings.push_back(candidates[candidate].padding);
+  }
+  return paddings;
+}
+
+unsigned int getAdvisedPadding(const unsigned int M, const unsigned int N, const std::size_t typeSize, const unsigned int alignment, const paddingModel & model) {
+  return getPaddingCandidates(M, N, typeSize, alignment, 1, model).at(0);
+}
+
+} // OpenCL
+} // isa
@@ -0,0 +1,118 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <TransposePartition.hpp>
+
+namespace isa {
+namespace OpenCL {
+
+transposePartition::transposePartition(cl::Context & clContext, std::vector< cl::CommandQueue > & clQueues, const unsigned int M, const unsigned int N, const unsigned int padding, const std::size_t typeSize, const std::vector< double > & weights) : clQueues(clQueues), M(M), N(N), padding(padding), typeSize(typeSize), firstRows(clQueues.size() + 1, 0), confs(clQueues.size()), kernels(clQueues.size(), 0) {
+  double totalWeight = 0.0;
+  double weight = 0.0;
+
+  if ( clQueues.empty() ) {
+    throw std::invalid_argument("The partition needs at least one queue.");
+  } else if ( weights.size() != clQueues.size() ) {
+    throw std::invalid_argument("The partition needs one weight per queue.");
+  }
+  for ( unsigned int partition = 0; partition < clQueues.size(); partition++ ) {
+    if ( weights[partition] < 0.0 ) {
+      throw std::invalid_argument("The weights of the partition can not be negative.");
+    }
+    totalWeight += weights[partition];
+  }
+  if ( totalWeight <= 0.0 ) {
+    throw std::invalid_argument("At least one weight of the partition must be positive.");
+  }
+  for ( unsigned int partition = 0; partition < clQueues.size(); partition++ ) {
+    weight += weights[partition];
+    firstRows[partition + 1] = std::round((M * weight) / totalWeight);
+  }
+  firstRows[clQueues.size()] = M;
+  for ( unsigned int partition = 0; partition < clQueues.size(); partition++ ) {
+    // Empty partitions still get a valid buffer
+    const unsigned int nrRows = std::max(getNrRows(partition), 1u);
+
+    input_d.push_back(cl::Buffer(clContext, CL_MEM_READ_ONLY, nrRows * isa::utils::pad(N, padding) * typeSize, 0, 0));
+    output_d.push_back(cl::Buffer(clContext, CL_MEM_WRITE_ONLY, N * isa::utils::pad(nrRows, padding) * typeSize, 0, 0));
+  }
+}
+
+transposePartition::~transposePartition() {
+  for ( unsigned int partition = 0; partition < kernels.size(); partition++ ) {
+    delete kernels[partition];
+  }
+}
+
+void transposePartition::setKernel(const unsigned int partition, const transposeConf & conf, cl::Kernel * kernel) {
+  delete kernels[partition];
+  confs[partition] = conf;
+  kernels[partition] = kernel;
+}
+
+void transposePartition::run(const void * input, void * output) {
+  const std::size_t inputPitch = isa::utils::pad(N, padding) * typeSize;
+
+  for ( unsigned int partition = 0; partition < clQueues.size(); partition++ ) {
+    const unsigned int firstRow = getFirstRow(partition);
+    const unsigned int nrRows = getNrRows(partition);
+    cl::NDRange global(std::ceil(static_cast< double >(nrRows) / confs[partition].getTileHeight()) * confs[partition].getNrThreads(), std::ceil(static_cast< double >(N) / confs[partition].getTileWidth()));
+    cl::NDRange local(confs[partition].getNrThreads(), 1);
+    cl::size_t< 3 > bufferOrigin;
+    cl::size_t< 3 > hostOrigin;
+    cl::size_t< 3 > region;
+
+    if ( nrRows == 0 ) {
+      continue;
+    }
+    bufferOrigin[0] = 0;
+    bufferOrigin[1] = 0;
+    bufferOrigin[2] = 0;
+    hostOrigin[0] = firstRow * typeSize;
+    hostOrigin[1] = 0;
+    hostOrigin[2] = 0;
+    region[0] = nrRows * typeSize;
+    region[1] = N;
+    region[2] = 1;
+    clQueues[partition].enqueueWriteBuffer(input_d[partition], CL_FALSE, 0, nrRows * inputPitch, reinterpret_cast< const char * >(input) + (firstRow * inputPitch));
+    kernels[partition]->setArg(0, input_d[partition]);
+    kernels[partition]->setArg(1, output_d[partition]);
+    clQueues[partition].enqueueNDRangeKernel(*kernels[partition], cl::NullRange, global, local);
+    // The columns of the partition go straight to their place in the output
+    clQueues[partition].enqueueReadBufferRect(output_d[partition], CL_FALSE, bufferOrigin, hostOrigin, region, isa::utils::pad(nrRows, padding) * typeSize, 0, isa::utils::pad(M, padding) * typeSize, 0, output);
+    clQueues[partition].flush();
+  }
+  for ( unsigned int partition = 0; partition < clQueues.size(); partition++ ) {
+    clQueues[partition].finish();
+  }
+}
+
+std::vector< cl::Device > getNUMASubDevices(cl::Device & clDevice) {
+  std::vector< cl::Device > subDevices;
+  const cl_device_partition_property properties[] = {CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN, CL_DEVICE_AFFINITY_DOMAIN_NUMA, 0};
+
+  try {
+    clDevice.createSubDevices(properties, &subDevices);
+  } catch ( cl::Error & err ) {
+    subDevices.clear();
+  }
+  return subDevices;
+}
+
+} // OpenCL
+} // isa
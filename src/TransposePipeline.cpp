@@ -0,0 +1,72 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <TransposePipeline.hpp>
+
+namespace isa {
+namespace OpenCL {
+
+transposePipeline::transposePipeline(cl::Context & clContext, std::vector< cl::CommandQueue > & clQueues, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int panelRows, const std::size_t typeSize) : clQueues(clQueues), M(M), N(N), padding(padding), panelRows(std::min(panelRows, M)), typeSize(typeSize) {
+  if ( clQueues.empty() ) {
+    throw std::invalid_argument("The pipeline needs at least one queue.");
+  }
+  for ( unsigned int queue = 0; queue < clQueues.size(); queue++ ) {
+    input_d.push_back(cl::Buffer(clContext, CL_MEM_READ_ONLY, this->panelRows * isa::utils::pad(N, padding) * typeSize, 0, 0));
+    output_d.push_back(cl::Buffer(clContext, CL_MEM_WRITE_ONLY, N * isa::utils::pad(this->panelRows, padding) * typeSize, 0, 0));
+  }
+}
+
+transposePipeline::~transposePipeline() {}
+
+void transposePipeline::run(cl::Kernel & kernel, const transposeConf & conf, const void * input, void * output) {
+  cl::NDRange global(std::ceil(static_cast< double >(panelRows) / conf.getTileHeight()) * conf.getNrThreads(), std::ceil(static_cast< double >(N) / conf.getTileWidth()));
+  cl::NDRange local(conf.getNrThreads(), 1);
+  const std::size_t inputPitch = isa::utils::pad(N, padding) * typeSize;
+
+  for ( unsigned int panel = 0; panel < getNrPanels(); panel++ ) {
+    const unsigned int queue = panel % clQueues.size();
+    const unsigned int firstRow = panel * panelRows;
+    const unsigned int nrRows = std::min(panelRows, M - firstRow);
+    cl::size_t< 3 > bufferOrigin;
+    cl::size_t< 3 > hostOrigin;
+    cl::size_t< 3 > region;
+
+    bufferOrigin[0] = 0;
+    bufferOrigin[1] = 0;
+    bufferOrigin[2] = 0;
+    hostOrigin[0] = firstRow * typeSize;
+    hostOrigin[1] = 0;
+    hostOrigin[2] = 0;
+    region[0] = nrRows * typeSize;
+    region[1] = N;
+    region[2] = 1;
+    // The queues are in order, so a pair of buffers is reused only after its previous panel has been downloaded
+    clQueues[queue].enqueueWriteBuffer(input_d[queue], CL_FALSE, 0, nrRows * inputPitch, reinterpret_cast< const char * >(input) + (firstRow * inputPitch));
+    kernel.setArg(0, input_d[queue]);
+    kernel.setArg(1, output_d[queue]);
+    clQueues[queue].enqueueNDRangeKernel(kernel, cl::NullRange, global, local);
+    // The columns of the panel go straight to their place in the output
+    clQueues[queue].enqueueReadBufferRect(output_d[queue], CL_FALSE, bufferOrigin, hostOrigin, region, isa::utils::pad(panelRows, padding) * typeSize, 0, isa::utils::pad(M, padding) * typeSize, 0, output);
+  }
+  for ( unsigned int queue = 0; queue < clQueues.size(); queue++ ) {
+    clQueues[queue].finish();
+  }
+}
+
+} // OpenCL
+} // isa
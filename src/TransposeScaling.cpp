@@ -0,0 +1,234 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <exception>
+#include <stdexcept>
+#include <iomanip>
+#include <algorithm>
+#include <ctime>
+
+#include <ArgumentList.hpp>
+#include <InitializeOpenCL.hpp>
+#include <Kernel.hpp>
+#include <utils.hpp>
+#include <Timer.hpp>
+#include <Transpose.hpp>
+#include <KernelCache.hpp>
+#include <TransposeSelector.hpp>
+#include <TransposePartition.hpp>
+
+typedef float dataType;
+std::string typeName("float");
+
+// Host to host GB/s of the transpose of nrElements elements, 0 if the output is wrong
+double measurePartition(isa::OpenCL::transposePartition & partition, std::vector< dataType > & input, std::vector< dataType > & output, const std::vector< dataType > & output_c, const long long unsigned int nrElements, const unsigned int nrIterations);
+
+int main(int argc, char * argv[]) {
+  bool subDevices = false;
+  unsigned int nrIterations = 0;
+  unsigned int clPlatformID = 0;
+  unsigned int clDeviceID = 0;
+  unsigned int nrDevices = 1;
+  unsigned int padding = 0;
+  unsigned int vector = 0;
+  unsigned int M = 0;
+  unsigned int N = 0;
+  std::string selectorFilename;
+  isa::OpenCL::transposeConf conf;
+
+  try {
+    isa::utils::ArgumentList args(argc, argv);
+
+    if ( args.getSwitch("-selector") ) {
+      selectorFilename = args.getSwitchArgument< std::string >("-selector_file");
+    }
+    subDevices = args.getSwitch("-sub_devices");
+    nrIterations = args.getSwitchArgument< unsigned int >("-iterations");
+    clPlatformID = args.getSwitchArgument< unsigned int >("-opencl_platform");
+    clDeviceID = args.getSwitchArgument< unsigned int >("-opencl_device");
+    if ( ! subDevices ) {
+      nrDevices = args.getSwitchArgument< unsigned int >("-nr_devices");
+    }
+    padding = args.getSwitchArgument< unsigned int >("-padding");
+    vector = args.getSwitchArgument< unsigned int >("-vector");
+    conf.setTileWidth(args.getSwitchArgument< unsigned int >("-width"));
+    conf.setTileHeight(args.getSwitchArgument< unsigned int >("-height"));
+    conf.setNrItemsPerThread(args.getSwitchArgument< unsigned int >("-items"));
+    conf.setLocalPadding(args.getSwitchArgument< unsigned int >("-local_padding"));
+    conf.setVectorWidth(args.getSwitchArgument< unsigned int >("-vector_width"));
+    conf.setDirectWrite(args.getSwitchArgument< unsigned int >("-direct_write"));
+    conf.setDiagonal(args.getSwitchArgument< unsigned int >("-diagonal"));
+    M = args.getSwitchArgument< unsigned int >("-M");
+    N = args.getSwitchArgument< unsigned int >("-N");
+  } catch ( isa::utils::EmptyCommandLine & err ) {
+    std::cerr << argv[0] << " [-selector -selector_file ...] [-sub_devices] -iterations ... -opencl_platform ... -opencl_device ... [-nr_devices ...] -padding ... -vector ... -width ... -height ... -items ... -local_padding ... -vector_width ... -direct_write ... -diagonal ... -M ... -N ..." << std::endl;
+    std::cerr << "Without -sub_devices the partitions are the devices from -opencl_device to -opencl_device + -nr_devices - 1, with -sub_devices they are the NUMA nodes of -opencl_device." << std::endl;
+    std::cerr << "With -selector every partition uses the configuration tuned for its device and shape, -width ... -vector_width are the fallback." << std::endl;
+    return 1;
+  } catch ( std::exception & err ) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  // Initialize OpenCL
+  cl::Context clContext;
+  std::vector< cl::Platform > * clPlatforms = new std::vector< cl::Platform >();
+  std::vector< cl::Device > * clDevices = new std::vector< cl::Device >();
+  std::vector< std::vector< cl::CommandQueue > > * clQueues = new std::vector< std::vector < cl::CommandQueue > >();
+  std::vector< cl::Device > partitionDevices;
+  std::vector< cl::CommandQueue > partitionQueues;
+
+  isa::OpenCL::initializeOpenCL(clPlatformID, 1, clPlatforms, &clContext, clDevices, clQueues);
+  if ( subDevices ) {
+    // Sub-devices need a context of their own
+    partitionDevices = isa::OpenCL::getNUMASubDevices(clDevices->at(clDeviceID));
+    if ( partitionDevices.size() == 0 ) {
+      std::cerr << "It is not possible to partition the device by NUMA node." << std::endl;
+      return 1;
+    }
+    clContext = cl::Context(partitionDevices);
+    for ( unsigned int device = 0; device < partitionDevices.size(); device++ ) {
+      partitionQueues.push_back(cl::CommandQueue(clContext, partitionDevices[device]));
+    }
+  } else {
+    if ( clDeviceID + nrDevices > clDevices->size() ) {
+      std::cerr << "There are only " << clDevices->size() << " devices." << std::endl;
+      return 1;
+    }
+    for ( unsigned int device = clDeviceID; device < clDeviceID + nrDevices; device++ ) {
+      partitionDevices.push_back(clDevices->at(device));
+      partitionQueues.push_back(clQueues->at(device)[0]);
+    }
+  }
+
+  // Allocate memory
+  std::vector< dataType > input(M * isa::utils::pad(N, padding));
+  std::vector< dataType > output(N * isa::utils::pad(M, padding));
+  std::vector< dataType > output_c(N * isa::utils::pad(M, padding));
+
+  srand(time(0));
+  for ( std::vector< dataType >::iterator item = input.begin(); item != input.end(); ++item ) {
+    *item = static_cast< dataType >(rand() % 10);
+  }
+  isa::OpenCL::transpose(M, N, padding, input, output_c);
+
+  isa::OpenCL::transposeSelector selector;
+  isa::OpenCL::kernelCache cache("");
+
+  if ( ! selectorFilename.empty() ) {
+    try {
+      selector.read(selectorFilename);
+    } catch ( std::runtime_error & err ) {
+      std::cerr << err.what() << std::endl;
+      return 1;
+    }
+  }
+  // Configuration and kernel for nrRows rows on a device
+  auto getKernel = [&](cl::Device & clDevice, const unsigned int nrRows, isa::OpenCL::transposeConf & partitionConf) {
+    partitionConf = conf;
+    try {
+      partitionConf = selector.select(clDevice.getInfo< CL_DEVICE_NAME >(), typeName, nrRows, N, padding);
+    } catch ( std::out_of_range & err ) {
+      // Not tuned, use the configuration from the command line
+    }
+    std::string configuration = isa::utils::toString(nrRows) + " " + isa::utils::toString(N) + " " + isa::utils::toString(padding) + " " + isa::utils::toString(vector) + " " + typeName + " " + partitionConf.print();
+    auto generator = [&]() {
+      return isa::OpenCL::getTransposeOpenCL(partitionConf, nrRows, N, padding, vector, typeName);
+    };
+
+    return cache.getKernel("transpose", configuration, generator, "-cl-mad-enable -Werror", clContext, clDevice);
+  };
+
+  std::vector< double > singleGBs(partitionDevices.size());
+  double partitionedGBs = 0.0;
+
+  std::cout << std::fixed << std::endl;
+  std::cout << "# M N partition device rows tileWidth tileHeight nrItemsPerThread localPadding vectorWidth directWrite diagonal [GB/s]" << std::endl;
+  std::cout << "# single lines are every device alone, partition lines the share of every device; GB/s is host to host" << std::endl << std::endl;
+  try {
+    // Every device alone
+    for ( unsigned int device = 0; device < partitionDevices.size(); device++ ) {
+      std::vector< cl::CommandQueue > queue(1, partitionQueues[device]);
+      isa::OpenCL::transposePartition single(clContext, queue, M, N, padding, sizeof(dataType), std::vector< double >(1, 1.0));
+      isa::OpenCL::transposeConf singleConf;
+      cl::Kernel * kernel = getKernel(partitionDevices[device], M, singleConf);
+
+      single.setKernel(0, singleConf, kernel);
+      singleGBs[device] = measurePartition(single, input, output, output_c, static_cast< long long unsigned int >(M) * N, nrIterations);
+      std::cout << M << " " << N << " single " << device << " " << M << " " << singleConf.print() << " ";
+      std::cout << std::setprecision(3) << singleGBs[device] << std::endl;
+      if ( singleGBs[device] == 0.0 ) {
+        std::cerr << "Wrong output on device " << device << "." << std::endl;
+        return 1;
+      }
+    }
+    // All devices together, the rows are split in proportion to the throughput of every device alone
+    isa::OpenCL::transposePartition partitioned(clContext, partitionQueues, M, N, padding, sizeof(dataType), singleGBs);
+
+    for ( unsigned int device = 0; device < partitionDevices.size(); device++ ) {
+      isa::OpenCL::transposeConf partitionConf;
+
+      if ( partitioned.getNrRows(device) > 0 ) {
+        cl::Kernel * kernel = getKernel(partitionDevices[device], partitioned.getNrRows(device), partitionConf);
+
+        partitioned.setKernel(device, partitionConf, kernel);
+      }
+      std::cout << M << " " << N << " partition " << device << " " << partitioned.getNrRows(device) << " " << partitionConf.print() << std::endl;
+    }
+    partitionedGBs = measurePartition(partitioned, input, output, output_c, static_cast< long long unsigned int >(M) * N, nrIterations);
+  } catch ( isa::OpenCL::OpenCLError & err ) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  } catch ( cl::Error & err ) {
+    std::cerr << "OpenCL error: " << isa::utils::toString(err.err()) << "." << std::endl;
+    return 1;
+  }
+
+  // Speedup is against the fastest device alone, efficiency against the sum of all devices alone
+  double bestGBs = *std::max_element(singleGBs.begin(), singleGBs.end());
+  double totalGBs = 0.0;
+
+  for ( unsigned int device = 0; device < singleGBs.size(); device++ ) {
+    totalGBs += singleGBs[device];
+  }
+  std::cout << std::endl;
+  std::cout << std::setprecision(3);
+  std::cout << "# partitioned: " << partitionedGBs << " GB/s on " << partitionDevices.size() << " devices, speedup " << partitionedGBs / bestGBs << ", efficiency " << (partitionedGBs * 100.0) / totalGBs << "%" << std::endl;
+  if ( partitionedGBs == 0.0 ) {
+    std::cout << "# wrong output of the partitioned transpose" << std::endl;
+  }
+  std::cout << std::endl;
+
+  return 0;
+}
+
+double measurePartition(isa::OpenCL::transposePartition & partition, std::vector< dataType > & input, std::vector< dataType > & output, const std::vector< dataType > & output_c, const long long unsigned int nrElements, const unsigned int nrIterations) {
+  isa::utils::Timer timer;
+
+  // Warm-up run, also checking the output
+  std::fill(output.begin(), output.end(), static_cast< dataType >(0));
+  partition.run(input.data(), output.data());
+  if ( ! std::equal(output.begin(), output.end(), output_c.begin()) ) {
+    return 0.0;
+  }
+  for ( unsigned int iteration = 0; iteration < nrIterations; iteration++ ) {
+    timer.start();
+    partition.run(input.data(), output.data());
+    timer.stop();
+  }
+  return isa::utils::giga(nrElements * 2 * sizeof(dataType)) / timer.getAverageTime();
+}
@@ -0,0 +1,164 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+
+#include <TransposeSearch.hpp>
+
+namespace isa {
+namespace OpenCL {
+
+transposeSearch::transposeSearch(const std::vector< transposeConf > & configurations) : configurations(configurations), bestGBs(0.0), best(0) {}
+
+transposeSearch::~transposeSearch() {}
+
+void transposeSearch::update(const unsigned int configuration, const double gbs) {
+  if ( gbs > bestGBs ) {
+    bestGBs = gbs;
+    best = configuration;
+  }
+}
+
+exhaustiveSearch::exhaustiveSearch(const std::vector< transposeConf > & configurations) : transposeSearch(configurations), order(configurations.size()), position(0) {
+  for ( unsigned int configuration = 0; configuration < order.size(); configuration++ ) {
+    order[configuration] = configuration;
+  }
+}
+
+exhaustiveSearch::~exhaustiveSearch() {}
+
+bool exhaustiveSearch::next(unsigned int & configuration) {
+  if ( position >= order.size() ) {
+    return false;
+  }
+  configuration = order[position++];
+  return true;
+}
+
+std::vector< unsigned int > exhaustiveSearch::lookahead(const unsigned int nrConfigurations) const {
+  return std::vector< unsigned int >(order.begin() + position, order.begin() + std::min(static_cast< std::size_t >(position + nrConfigurations), order.size()));
+}
+
+randomSearch::randomSearch(const std::vector< transposeConf > & configurations, const unsigned int nrSamples, const unsigned int seed) : exhaustiveSearch(configurations) {
+  std::mt19937 generator(seed);
+
+  std::shuffle(order.begin(), order.end(), generator);
+  if ( nrSamples < order.size() ) {
+    order.resize(nrSamples);
+  }
+}
+
+randomSearch::~randomSearch() {}
+
+annealingSearch::annealingSearch(const std::vector< transposeConf > & configurations, const double budget, const unsigned int seed) : transposeSearch(configurations), budget(budget), start(std::chrono::steady_clock::now()), nrSteps(0), visited(configurations.size(), false), nrVisited(0), current(0), currentGBs(0.0), generator(seed) {
+  if ( configurations.size() > 0 ) {
+    current = std::uniform_int_distribution< unsigned int >(0, configurations.size() - 1)(generator);
+  }
+}
+
+annealingSearch::~annealingSearch() {}
+
+double annealingSearch::getTemperature() const {
+  double progress = 0.0;
+
+  if ( budget > 0.0 ) {
+    progress = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count() / budget;
+  } else {
+    progress = static_cast< double >(nrSteps) / configurations.size();
+  }
+  return std::max(1.0 - progress, 0.0);
+}
+
+void annealingSearch::plan() {
+  const transposeConf & conf = configurations[current];
+
+  candidates.clear();
+  for ( unsigned int candidate = 0; candidate < configurations.size(); candidate++ ) {
+    const transposeConf & other = configurations[candidate];
+    unsigned int nrDifferences = 0;
+
+    if ( visited[candidate] ) {
+      continue;
+    }
+    nrDifferences += (other.getTileWidth() != conf.getTileWidth());
+    nrDifferences += (other.getTileHeight() != conf.getTileHeight());
+    nrDifferences += (other.getNrItemsPerThread() != conf.getNrItemsPerThread());
+    nrDifferences += (other.getLocalPadding() != conf.getLocalPadding());
+    nrDifferences += (other.getVectorWidth() != conf.getVectorWidth());
+    nrDifferences += (other.getDirectWrite() != conf.getDirectWrite());
+    nrDifferences += (other.getDiagonal() != conf.getDiagonal());
+    if ( nrDifferences == 1 ) {
+      candidates.push_back(candidate);
+    }
+  }
+  std::shuffle(candidates.begin(), candidates.end(), generator);
+}
+
+bool annealingSearch::next(unsigned int & configuration) {
+  if ( nrVisited >= configurations.size() ) {
+    return false;
+  }
+  while ( candidates.size() > 0 && visited[candidates.front()] ) {
+    candidates.erase(candidates.begin());
+  }
+  if ( nrSteps == 0 ) {
+    configuration = current;
+  } else if ( candidates.size() > 0 ) {
+    configuration = candidates.front();
+    candidates.erase(candidates.begin());
+  } else {
+    // Neighbourhood fully explored, restart from a random configuration not tried yet
+    std::vector< unsigned int > unvisited;
+
+    for ( unsigned int candidate = 0; candidate < configurations.size(); candidate++ ) {
+      if ( ! visited[candidate] ) {
+        unvisited.push_back(candidate);
+      }
+    }
+    configuration = unvisited[std::uniform_int_distribution< unsigned int >(0, unvisited.size() - 1)(generator)];
+  }
+  visited[configuration] = true;
+  nrVisited++;
+  nrSteps++;
+  return true;
+}
+
+std::vector< unsigned int > annealingSearch::lookahead(const unsigned int nrConfigurations) const {
+  std::vector< unsigned int > upcoming;
+
+  for ( std::vector< unsigned int >::const_iterator candidate = candidates.begin(); candidate != candidates.end() && upcoming.size() < nrConfigurations; ++candidate ) {
+    if ( ! visited[*candidate] ) {
+      upcoming.push_back(*candidate);
+    }
+  }
+  return upcoming;
+}
+
+void annealingSearch::update(const unsigned int configuration, const double gbs) {
+  const double temperature = getTemperature();
+
+  transposeSearch::update(configuration, gbs);
+  // Always move uphill, move downhill with a probability that decreases with the temperature and the loss
+  if ( (gbs >= currentGBs) || (temperature > 0.0 && std::uniform_real_distribution< double >(0.0, 1.0)(generator) < std::exp((gbs - currentGBs) / (currentGBs * temperature * 0.1))) ) {
+    current = configuration;
+    currentGBs = gbs;
+    plan();
+  } else if ( candidates.size() == 0 ) {
+    plan();
+  }
+}
+
+} // OpenCL
+} // isa
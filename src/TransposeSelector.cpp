@@ -0,0 +1,184 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+
+#include <TransposeSelector.hpp>
+
+namespace isa {
+namespace OpenCL {
+
+// File header, followed by the version and the number of entries
+static const char selectorMagic[4] = {'T', 'S', 'E', 'L'};
+static const std::uint32_t selectorVersion = 2;
+
+template< typename T > static void writeValue(std::ofstream & file, const T value) {
+  file.write(reinterpret_cast< const char * >(&value), sizeof(T));
+}
+
+template< typename T > static T readValue(std::ifstream & file) {
+  T value = T();
+
+  if ( ! file.read(reinterpret_cast< char * >(&value), sizeof(T)) ) {
+    throw std::runtime_error("Truncated tuned configurations file.");
+  }
+  return value;
+}
+
+static void writeString(std::ofstream & file, const std::string & text) {
+  writeValue< std::uint32_t >(file, text.size());
+  file.write(text.data(), text.size());
+}
+
+static std::string readString(std::ifstream & file) {
+  std::string text(readValue< std::uint32_t >(file), '\0');
+
+  if ( ! file.read(&text[0], text.size()) ) {
+    throw std::runtime_error("Truncated tuned configurations file.");
+  }
+  return text;
+}
+
+transposeSelector::transposeSelector() : nrEntries(0) {}
+
+transposeSelector::~transposeSelector() {}
+
+void transposeSelector::insert(const std::string & deviceName, const std::string & typeName, const unsigned int M, const unsigned int N, const unsigned int padding, const transposeConf & conf, const double gbs) {
+  std::vector< tunedTransposeEntry > & shapes = entries[deviceName][typeName];
+  tunedTransposeEntry entry = {M, N, padding, conf, gbs};
+
+  for ( std::vector< tunedTransposeEntry >::iterator shape = shapes.begin(); shape != shapes.end(); ++shape ) {
+    if ( shape->M == M && shape->N == N && shape->padding == padding ) {
+      if ( shape->gbs < gbs ) {
+        *shape = entry;
+      }
+      return;
+    }
+  }
+  shapes.push_back(entry);
+  nrEntries++;
+}
+
+bool transposeSelector::contains(const std::string & deviceName, const std::string & typeName, const unsigned int M, const unsigned int N, const unsigned int padding) const {
+  std::map< std::string, std::map< std::string, std::vector< tunedTransposeEntry > > >::const_iterator device = entries.find(deviceName);
+
+  if ( device == entries.end() || device->second.count(typeName) == 0 ) {
+    return false;
+  }
+  const std::vector< tunedTransposeEntry > & shapes = device->second.at(typeName);
+  for ( std::vector< tunedTransposeEntry >::const_iterator shape = shapes.begin(); shape != shapes.end(); ++shape ) {
+    if ( shape->M == M && shape->N == N && shape->padding == padding ) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const transposeConf & transposeSelector::select(const std::string & deviceName, const std::string & typeName, const unsigned int M, const unsigned int N, const unsigned int padding) const {
+  std::map< std::string, std::map< std::string, std::vector< tunedTransposeEntry > > >::const_iterator device = entries.find(deviceName);
+
+  if ( device == entries.end() || device->second.count(typeName) == 0 || device->second.at(typeName).size() == 0 ) {
+    throw std::out_of_range("No tuned configuration for " + typeName + " on " + deviceName + ".");
+  }
+  const std::vector< tunedTransposeEntry > & shapes = device->second.at(typeName);
+  const tunedTransposeEntry * best = 0;
+  double bestDistance = std::numeric_limits< double >::max();
+
+  // Every configuration is valid for every shape, so the closest tuned shape is a safe guess; a different padding counts as a factor 16 in size
+  for ( std::vector< tunedTransposeEntry >::const_iterator shape = shapes.begin(); shape != shapes.end(); ++shape ) {
+    double distance = std::pow(std::log2(static_cast< double >(std::max(shape->M, 1u)) / std::max(M, 1u)), 2.0) + std::pow(std::log2(static_cast< double >(std::max(shape->N, 1u)) / std::max(N, 1u)), 2.0);
+
+    if ( shape->padding != padding ) {
+      distance += 16.0;
+    }
+    if ( distance < bestDistance ) {
+      bestDistance = distance;
+      best = &(*shape);
+    }
+  }
+  return best->conf;
+}
+
+void transposeSelector::read(const std::string & filename) {
+  std::ifstream file(filename, std::ios::binary);
+  char magic[4];
+
+  if ( ! file ) {
+    throw std::runtime_error("Impossible to open " + filename + ".");
+  }
+  if ( ! file.read(magic, 4) || ! std::equal(magic, magic + 4, selectorMagic) ) {
+    throw std::runtime_error(filename + " is not a tuned configurations file.");
+  }
+  if ( readValue< std::uint32_t >(file) != selectorVersion ) {
+    throw std::runtime_error("Unsupported version of " + filename + ".");
+  }
+  for ( std::uint32_t entry = readValue< std::uint32_t >(file); entry > 0; entry-- ) {
+    const std::string deviceName = readString(file);
+    const std::string typeName = readString(file);
+    const unsigned int M = readValue< std::uint32_t >(file);
+    const unsigned int N = readValue< std::uint32_t >(file);
+    const unsigned int padding = readValue< std::uint32_t >(file);
+    transposeConf conf;
+
+    conf.setTileWidth(readValue< std::uint32_t >(file));
+    conf.setTileHeight(readValue< std::uint32_t >(file));
+    conf.setNrItemsPerThread(readValue< std::uint32_t >(file));
+    conf.setLocalPadding(readValue< std::uint32_t >(file));
+    conf.setVectorWidth(readValue< std::uint32_t >(file));
+    conf.setDirectWrite(readValue< std::uint32_t >(file));
+    conf.setDiagonal(readValue< std::uint32_t >(file));
+    insert(deviceName, typeName, M, N, padding, conf, readValue< double >(file));
+  }
+}
+
+void transposeSelector::write(const std::string & filename) const {
+  std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+
+  if ( ! file ) {
+    throw std::runtime_error("Impossible to open " + filename + ".");
+  }
+  file.write(selectorMagic, 4);
+  writeValue< std::uint32_t >(file, selectorVersion);
+  writeValue< std::uint32_t >(file, nrEntries);
+  for ( std::map< std::string, std::map< std::string, std::vector< tunedTransposeEntry > > >::const_iterator device = entries.begin(); device != entries.end(); ++device ) {
+    for ( std::map< std::string, std::vector< tunedTransposeEntry > >::const_iterator type = device->second.begin(); type != device->second.end(); ++type ) {
+      for ( std::vector< tunedTransposeEntry >::const_iterator shape = type->second.begin(); shape != type->second.end(); ++shape ) {
+        writeString(file, device->first);
+        writeString(file, type->first);
+        writeValue< std::uint32_t >(file, shape->M);
+        writeValue< std::uint32_t >(file, shape->N);
+        writeValue< std::uint32_t >(file, shape->padding);
+        writeValue< std::uint32_t >(file, shape->conf.getTileWidth());
+        writeValue< std::uint32_t >(file, shape->conf.getTileHeight());
+        writeValue< std::uint32_t >(file, shape->conf.getNrItemsPerThread());
+        writeValue< std::uint32_t >(file, shape->conf.getLocalPadding());
+        writeValue< std::uint32_t >(file, shape->conf.getVectorWidth());
+        writeValue< std::uint32_t >(file, shape->conf.getDirectWrite());
+        writeValue< std::uint32_t >(file, shape->conf.getDiagonal());
+        writeValue< double >(file, shape->gbs);
+      }
+    }
+  }
+  if ( ! file ) {
+    throw std::runtime_error("Error writing " + filename + ".");
+  }
+}
+
+} // OpenCL
+} // isa
@@ -0,0 +1,124 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <TransposeStream.hpp>
+
+namespace isa {
+namespace OpenCL {
+
+mappedFile::mappedFile(const std::string & filename, const std::size_t size, const bool writable) : fileDescriptor(-1), data(0), size(size) {
+  struct stat fileStatus;
+
+  fileDescriptor = open(filename.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+  if ( fileDescriptor < 0 ) {
+    throw std::runtime_error("Impossible to open " + filename + ": " + std::strerror(errno) + ".");
+  }
+  if ( writable ) {
+    if ( ftruncate(fileDescriptor, size) != 0 ) {
+      close(fileDescriptor);
+      throw std::runtime_error("Impossible to resize " + filename + ": " + std::strerror(errno) + ".");
+    }
+  } else if ( (fstat(fileDescriptor, &fileStatus) != 0) || (static_cast< std::size_t >(fileStatus.st_size) < size) ) {
+    close(fileDescriptor);
+    throw std::runtime_error("The file " + filename + " is smaller than " + isa::utils::toString(size) + " bytes.");
+  }
+  if ( size == 0 ) {
+    return;
+  }
+  data = mmap(0, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fileDescriptor, 0);
+  if ( data == MAP_FAILED ) {
+    data = 0;
+    close(fileDescriptor);
+    throw std::runtime_error("Impossible to map " + filename + ": " + std::strerror(errno) + ".");
+  }
+}
+
+mappedFile::~mappedFile() {
+  if ( data != 0 ) {
+    munmap(data, size);
+  }
+  close(fileDescriptor);
+}
+
+// madvise() works on whole pages
+static void pageAlign(const std::size_t fileSize, std::size_t & offset, std::size_t & size) {
+  const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+  const std::size_t end = std::min(offset + size, fileSize);
+
+  offset = (offset / pageSize) * pageSize;
+  size = (end > offset) ? end - offset : 0;
+}
+
+void mappedFile::willNeed(const std::size_t offset, const std::size_t size) const {
+  std::size_t alignedOffset = offset;
+  std::size_t alignedSize = size;
+
+  pageAlign(this->size, alignedOffset, alignedSize);
+  if ( alignedSize > 0 ) {
+    madvise(reinterpret_cast< char * >(data) + alignedOffset, alignedSize, MADV_WILLNEED);
+  }
+}
+
+void mappedFile::dontNeed(const std::size_t offset, const std::size_t size) const {
+  std::size_t alignedOffset = offset;
+  std::size_t alignedSize = size;
+
+  pageAlign(this->size, alignedOffset, alignedSize);
+  if ( alignedSize > 0 ) {
+    madvise(reinterpret_cast< char * >(data) + alignedOffset, alignedSize, MADV_DONTNEED);
+  }
+}
+
+void mappedFile::touch(const std::size_t offset, const std::size_t size) const {
+  const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+  const volatile char * bytes = reinterpret_cast< const volatile char * >(data);
+
+  for ( std::size_t item = offset; item < std::min(offset + size, this->size); item += pageSize ) {
+    bytes[item];
+  }
+}
+
+void mappedFile::flush() const {
+  if ( data != 0 ) {
+    msync(data, size, MS_ASYNC);
+  }
+}
+
+unsigned int getTransposePanelRows(const unsigned int M, const unsigned int N, const unsigned int padding, const std::size_t typeSize, const std::size_t memoryBudget, const unsigned int rowMultiple) {
+  const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+  // Two input panels (one is prefetched), plus the output pages touched by a panel
+  const std::size_t rowSize = ((2 * static_cast< std::size_t >(isa::utils::pad(N, padding))) + N) * typeSize;
+  const std::size_t outputOverhead = static_cast< std::size_t >(N) * pageSize;
+  std::size_t rows = rowMultiple;
+
+  if ( rowMultiple == 0 ) {
+    throw std::invalid_argument("The rows of a panel must be a multiple of a positive number.");
+  }
+  if ( memoryBudget > outputOverhead ) {
+    rows = std::max(((memoryBudget - outputOverhead) / rowSize / rowMultiple) * rowMultiple, static_cast< std::size_t >(rowMultiple));
+  }
+
+  return std::min(rows, static_cast< std::size_t >(isa::utils::pad(M, rowMultiple)));
+}
+
+} // OpenCL
+} // isa
@@ -16,31 +16,104 @@
 #include <string>
 #include <vector>
 #include <exception>
+#include <stdexcept>
 #include <fstream>
 #include <iomanip>
 #include <limits>
 #include <ctime>
 #include <cmath>
+#include <algorithm>
+#include <type_traits>
 
 #include <ArgumentList.hpp>
 #include <InitializeOpenCL.hpp>
 #include <Kernel.hpp>
 #include <utils.hpp>
 #include <Transpose.hpp>
+#include <Permute.hpp>
+#include <KernelCache.hpp>
+#include <TransposePipeline.hpp>
+#include <TransposeEngine.hpp>
+#include <TransposeFixed.hpp>
+#include <TransposePadding.hpp>
+#include <TransposeTypes.hpp>
 
-typedef float dataType;
-std::string typeName("float");
+// Input type of the fused conversion
+typedef unsigned char convertType;
+std::string convertTypeName("uchar");
 
+template< typename T > int testPermute(cl::Context & clContext, cl::Device & clDevice, cl::CommandQueue & clQueue, isa::OpenCL::kernelCache & cache, const isa::OpenCL::transposeConf & conf, const std::vector< unsigned int > & shape, const std::vector< unsigned int > & permutation, const unsigned int padding, const unsigned int vector, const bool printCode, const bool cpuTiled, const unsigned int cpuTile, const unsigned int cpuThreads);
+template< typename T > int testConvert(cl::Context & clContext, cl::Device & clDevice, cl::CommandQueue & clQueue, isa::OpenCL::kernelCache & cache, const isa::OpenCL::transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int vector, const float scale, const float offset, const bool printCode, const unsigned int cpuTile, const unsigned int cpuThreads);
+template< typename T > int testEngine(const unsigned int clPlatformID, const unsigned int clDeviceID, const unsigned int nrQueues, const std::string & cacheDirectory, const isa::OpenCL::transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int vector, const unsigned int nrRequests);
+template< typename T > int testView(cl::Context & clContext, cl::Device & clDevice, cl::CommandQueue & clQueue, isa::OpenCL::kernelCache & cache, const isa::OpenCL::transposeConf & conf, const unsigned int M, const unsigned int N, const isa::OpenCL::matrixView & inputView, const isa::OpenCL::matrixView & outputView, const unsigned int vector, const bool printCode);
+// The whole test, for elements of type T
+template< typename T > int testTranspose(int argc, char * argv[]);
+void printUsage(const std::string & name);
 
 int main(int argc, char *argv[]) {
+  std::string typeName;
+
+  try {
+    isa::utils::ArgumentList args(argc, argv);
+    typeName = args.getSwitchArgument< std::string >("-type");
+  } catch ( std::exception & err ) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  // Only the element type is chosen here, the test is compiled for each of them
+  if ( typeName == "float" ) {
+    return testTranspose< float >(argc, argv);
+  } else if ( typeName == "double" ) {
+    return testTranspose< double >(argc, argv);
+  } else if ( typeName == "half" ) {
+    return testTranspose< isa::OpenCL::halfType >(argc, argv);
+  } else if ( typeName == "float2" ) {
+    return testTranspose< isa::OpenCL::complexType >(argc, argv);
+  } else if ( typeName == "uchar" ) {
+    return testTranspose< unsigned char >(argc, argv);
+  }
+  std::cerr << "Unknown type \"" << typeName << "\"." << std::endl;
+  return 1;
+}
+
+void printUsage(const std::string & name) {
+  std::cerr << "Usage: " << name << " [-print_code] [-print_data] [-cache -cache_directory ...] [-in_place] [-permute -shape ... -permutation ...] [-pipeline -panel_rows ... -queues ...] [-convert -scale ... -offset ...] [-engine -requests ... -queues ...] [-view -input_view ... -output_view ...] [-cpu_tiled -cpu_tile ... -cpu_threads ...] [-cpu_fixed -cpu_tile ... -cpu_threads ...] [-cpu_recursive -cpu_threads ...] -type ... -opencl_platform ... -opencl_device ... [-padding_advisor] -padding ... -vector ... -width ... -height ... -items ... -local_padding ... -vector_width ... -direct_write ... -diagonal ... [-M ... -N ...]" << std::endl;
+  std::cerr << "The type is one of float, double, half, float2 (complex) and uchar; -convert needs float or double." << std::endl;
+}
+
+template< typename T > int testTranspose(int argc, char * argv[]) {
+  const std::string typeName = isa::OpenCL::getTransposeTypeName< T >();
   bool printCode = false;
   bool printData = false;
+  bool cpuTiled = false;
+  bool cpuFixed = false;
+  bool cpuRecursive = false;
+  bool inPlace = false;
+  bool permute = false;
+  bool pipeline = false;
+  bool convert = false;
+  bool engine = false;
+  bool view = false;
+  bool paddingAdvisor = false;
 	unsigned int clPlatformID = 0;
 	unsigned int clDeviceID = 0;
   unsigned int padding = 0;
   unsigned int vector = 0;
   unsigned int M = 0;
   unsigned int N = 0;
+  unsigned int cpuTile = 0;
+  unsigned int cpuThreads = 0;
+  unsigned int panelRows = 0;
+  unsigned int nrQueues = 1;
+  unsigned int nrRequests = 0;
+  float scale = 1.0f;
+  float offset = 0.0f;
+  std::string cacheDirectory;
+  isa::OpenCL::matrixView inputView;
+  isa::OpenCL::matrixView outputView;
+  std::vector< unsigned int > shape;
+  std::vector< unsigned int > permutation;
 	long long unsigned int wrongItems = 0;
   isa::OpenCL::transposeConf conf;
 
@@ -48,38 +121,169 @@ int main(int argc, char *argv[]) {
     isa::utils::ArgumentList args(argc, argv);
     printCode = args.getSwitch("-print_code");
     printData = args.getSwitch("-print_data");
+    if ( args.getSwitch("-cache") ) {
+      cacheDirectory = args.getSwitchArgument< std::string >("-cache_directory");
+    }
+    inPlace = args.getSwitch("-in_place");
+    permute = args.getSwitch("-permute");
+    if ( permute ) {
+      shape = isa::OpenCL::readPermuteAxes(args.getSwitchArgument< std::string >("-shape"));
+      permutation = isa::OpenCL::readPermuteAxes(args.getSwitchArgument< std::string >("-permutation"));
+    }
+    pipeline = args.getSwitch("-pipeline");
+    if ( pipeline ) {
+      panelRows = args.getSwitchArgument< unsigned int >("-panel_rows");
+      nrQueues = args.getSwitchArgument< unsigned int >("-queues");
+    }
+    engine = args.getSwitch("-engine");
+    if ( engine ) {
+      nrRequests = args.getSwitchArgument< unsigned int >("-requests");
+      nrQueues = args.getSwitchArgument< unsigned int >("-queues");
+    }
+    convert = args.getSwitch("-convert");
+    if ( convert ) {
+      scale = args.getSwitchArgument< float >("-scale");
+      offset = args.getSwitchArgument< float >("-offset");
+    }
+    view = args.getSwitch("-view");
+    if ( view ) {
+      inputView = isa::OpenCL::readMatrixView(args.getSwitchArgument< std::string >("-input_view"));
+      outputView = isa::OpenCL::readMatrixView(args.getSwitchArgument< std::string >("-output_view"));
+    }
+    cpuTiled = args.getSwitch("-cpu_tiled");
+    if ( cpuTiled ) {
+      cpuTile = args.getSwitchArgument< unsigned int >("-cpu_tile");
+      cpuThreads = args.getSwitchArgument< unsigned int >("-cpu_threads");
+    }
+    cpuFixed = args.getSwitch("-cpu_fixed");
+    if ( cpuFixed ) {
+      cpuTile = args.getSwitchArgument< unsigned int >("-cpu_tile");
+      cpuThreads = args.getSwitchArgument< unsigned int >("-cpu_threads");
+    }
+    cpuRecursive = args.getSwitch("-cpu_recursive");
+    if ( cpuRecursive ) {
+      cpuThreads = args.getSwitchArgument< unsigned int >("-cpu_threads");
+    }
 		clPlatformID = args.getSwitchArgument< unsigned int >("-opencl_platform");
 		clDeviceID = args.getSwitchArgument< unsigned int >("-opencl_device");
+    paddingAdvisor = args.getSwitch("-padding_advisor");
     padding = args.getSwitchArgument< unsigned int >("-padding");
     vector = args.getSwitchArgument< unsigned int >("-vector");
-    conf.setNrItemsPerBlock(args.getSwitchArgument< unsigned int >("-threads"));
-    M = args.getSwitchArgument< unsigned int >("-M");
-    N = args.getSwitchArgument< unsigned int >("-N");
+    conf.setTileWidth(args.getSwitchArgument< unsigned int >("-width"));
+    conf.setTileHeight(args.getSwitchArgument< unsigned int >("-height"));
+    conf.setNrItemsPerThread(args.getSwitchArgument< unsigned int >("-items"));
+    conf.setLocalPadding(args.getSwitchArgument< unsigned int >("-local_padding"));
+    conf.setVectorWidth(args.getSwitchArgument< unsigned int >("-vector_width"));
+    conf.setDirectWrite(args.getSwitchArgument< unsigned int >("-direct_write"));
+    conf.setDiagonal(args.getSwitchArgument< unsigned int >("-diagonal"));
+    if ( ! permute ) {
+      M = args.getSwitchArgument< unsigned int >("-M");
+      N = args.getSwitchArgument< unsigned int >("-N");
+    }
 	} catch  ( isa::utils::SwitchNotFound & err ) {
     std::cerr << err.what() << std::endl;
     return 1;
   }catch ( std::exception & err ) {
-    std::cerr << "Usage: " << argv[0] << " [-print_code] [-print_data] -opencl_platform ... -opencl_device ... -padding ... -vector ... -threads ... -M ... -N ..." << std::endl;
+    printUsage(argv[0]);
 		return 1;
 	}
 
+  if ( paddingAdvisor ) {
+    if ( permute || view ) {
+      std::cerr << "The padding advisor is not available for permutations and views." << std::endl;
+      return 1;
+    }
+    // -padding is the alignment, the advisor picks a multiple of it
+    unsigned int alignment = padding;
+
+    padding = isa::OpenCL::getAdvisedPadding(M, N, sizeof(T), alignment, isa::OpenCL::getDevicePaddingModel());
+    std::cout << "# padding advisor: " << padding << " instead of " << alignment << " (rows of " << isa::utils::pad(N, padding) << " and " << isa::utils::pad(M, padding) << " elements)" << std::endl;
+  }
+  if ( view && (inPlace || pipeline || permute || convert || engine) ) {
+    std::cerr << "Views are only available for the out-of-place transpose." << std::endl;
+    return 1;
+  }
+  if ( engine ) {
+    if ( inPlace || pipeline || permute || convert ) {
+      std::cerr << "The engine only runs the out-of-place transpose." << std::endl;
+      return 1;
+    }
+    return testEngine< T >(clPlatformID, clDeviceID, nrQueues, cacheDirectory, conf, M, N, padding, vector, nrRequests);
+  }
+
 	// Initialize OpenCL
 	cl::Context * clContext = new cl::Context();
 	std::vector< cl::Platform > * clPlatforms = new std::vector< cl::Platform >();
 	std::vector< cl::Device > * clDevices = new std::vector< cl::Device >();
 	std::vector< std::vector< cl::CommandQueue > > * clQueues = new std::vector< std::vector < cl::CommandQueue > >();
 
-  isa::OpenCL::initializeOpenCL(clPlatformID, 1, clPlatforms, clContext, clDevices, clQueues);
+  if ( convert && (inPlace || pipeline || permute) ) {
+    std::cerr << "The conversion is only available for the out-of-place transpose." << std::endl;
+    return 1;
+  }
+  if ( convert && ! std::is_floating_point< T >::value ) {
+    std::cerr << "The conversion is only available to float and double." << std::endl;
+    return 1;
+  }
+  if ( pipeline ) {
+    if ( inPlace ) {
+      std::cerr << "The pipeline is not available for the in-place transpose." << std::endl;
+      return 1;
+    }
+    panelRows = std::min(panelRows, M);
+  }
+  isa::OpenCL::initializeOpenCL(clPlatformID, nrQueues, clPlatforms, clContext, clDevices, clQueues);
+  if ( (typeName == "double") && (clDevices->at(clDeviceID).getInfo< CL_DEVICE_EXTENSIONS >().find("cl_khr_fp64") == std::string::npos) ) {
+    std::cerr << "The device does not support double." << std::endl;
+    return 1;
+  }
+
+  if ( permute ) {
+    isa::OpenCL::kernelCache cache(cacheDirectory);
+
+    return testPermute< T >(*clContext, clDevices->at(clDeviceID), clQueues->at(clDeviceID)[0], cache, conf, shape, permutation, padding, vector, printCode, cpuTiled, cpuTile, cpuThreads);
+  } else if ( convert ) {
+    isa::OpenCL::kernelCache cache(cacheDirectory);
+    // Only floating point types get here, the others are never converted to and do not need the test
+    typedef typename std::conditional< std::is_floating_point< T >::value, T, float >::type convertedType;
+
+    return testConvert< convertedType >(*clContext, clDevices->at(clDeviceID), clQueues->at(clDeviceID)[0], cache, conf, M, N, padding, vector, scale, offset, printCode, cpuTile, cpuThreads);
+  } else if ( view ) {
+    isa::OpenCL::kernelCache cache(cacheDirectory);
+
+    return testView< T >(*clContext, clDevices->at(clDeviceID), clQueues->at(clDeviceID)[0], cache, conf, M, N, inputView, outputView, vector, printCode);
+  }
 
 	// Allocate memory
-  std::vector< dataType > input = std::vector< dataType >(M * isa::utils::pad(N, padding));
+  std::vector< T > input;
   cl::Buffer input_d;
-  std::vector< dataType > output = std::vector< dataType >(N * isa::utils::pad(M, padding));
+  std::vector< T > output;
   cl::Buffer output_d;
-  std::vector< dataType > output_c = std::vector< dataType >(N * isa::utils::pad(M, padding));
+  std::vector< T > output_c;
+  std::vector< unsigned int > leaders;
+  cl::Buffer leaders_d;
+  if ( inPlace ) {
+    // The device holds a single buffer, big enough for both layouts
+    input = std::vector< T >(isa::OpenCL::getTransposeInPlaceSize(M, N, padding));
+    output = std::vector< T >(input.size());
+    if ( M != N ) {
+      leaders = isa::OpenCL::getTransposeInPlaceLeaders(M, N, padding);
+    }
+  } else {
+    input = std::vector< T >(M * isa::utils::pad(N, padding));
+    output = std::vector< T >(N * isa::utils::pad(M, padding));
+    output_c = std::vector< T >(N * isa::utils::pad(M, padding));
+  }
   try {
-    input_d = cl::Buffer(*clContext, CL_MEM_READ_ONLY, input.size() * sizeof(dataType), 0, 0);
-    output_d = cl::Buffer(*clContext, CL_MEM_WRITE_ONLY, output.size() * sizeof(dataType), 0, 0);
+    if ( inPlace ) {
+      input_d = cl::Buffer(*clContext, CL_MEM_READ_WRITE, input.size() * sizeof(T), 0, 0);
+      if ( leaders.size() > 0 ) {
+        leaders_d = cl::Buffer(*clContext, CL_MEM_READ_ONLY, leaders.size() * sizeof(unsigned int), 0, 0);
+      }
+    } else {
+      input_d = cl::Buffer(*clContext, CL_MEM_READ_ONLY, input.size() * sizeof(T), 0, 0);
+      output_d = cl::Buffer(*clContext, CL_MEM_WRITE_ONLY, output.size() * sizeof(T), 0, 0);
+    }
   } catch ( cl::Error & err ) {
     std::cerr << "OpenCL error allocating memory: " << isa::utils::toString< cl_int >(err.err()) << "." << std::endl;
     return 1;
@@ -88,27 +292,41 @@ int main(int argc, char *argv[]) {
 	srand(time(0));
   for ( unsigned int m = 0; m < M; m++ ) {
     for ( unsigned int n = 0; n < N; n++ ) {
-      input[(m * isa::utils::pad(N, padding)) + n] = static_cast< dataType >(rand() % 10);
+      input[(m * isa::utils::pad(N, padding)) + n] = isa::OpenCL::getRandomTransposeValue< T >();
     }
 	}
 
   // Copy data structures to device
   try {
-    clQueues->at(clDeviceID)[0].enqueueWriteBuffer(input_d, CL_FALSE, 0, input.size() * sizeof(dataType), reinterpret_cast< void * >(input.data()));
+    clQueues->at(clDeviceID)[0].enqueueWriteBuffer(input_d, CL_FALSE, 0, input.size() * sizeof(T), reinterpret_cast< void * >(input.data()));
+    if ( leaders.size() > 0 ) {
+      clQueues->at(clDeviceID)[0].enqueueWriteBuffer(leaders_d, CL_FALSE, 0, leaders.size() * sizeof(unsigned int), reinterpret_cast< void * >(leaders.data()));
+    }
   } catch ( cl::Error & err ) {
     std::cerr << "OpenCL error H2D transfer: " << isa::utils::toString< cl_int >(err.err()) << "." << std::endl;
     return 1;
   }
 
-  // Generate kernel
+  // Generate kernel, the pipeline transposes one panel at a time
   cl::Kernel * kernel;
-  std::string * code = isa::OpenCL::getTransposeOpenCL(conf, M, N, padding, vector, typeName);
+  isa::OpenCL::kernelCache cache(cacheDirectory);
+  const unsigned int kernelRows = pipeline ? panelRows : M;
+  std::string configuration = isa::utils::toString(kernelRows) + " " + isa::utils::toString(N) + " " + isa::utils::toString(padding) + " " + isa::utils::toString(vector) + " " + typeName + " " + conf.print();
+  auto generator = [&]() {
+    if ( inPlace ) {
+      return isa::OpenCL::getTransposeInPlaceOpenCL(conf, M, N, padding, vector, typeName);
+    }
+    return isa::OpenCL::getTransposeOpenCL(conf, kernelRows, N, padding, vector, typeName);
+  };
   if ( printCode ) {
+    std::string * code = generator();
+
     std::cout << *code << std::endl;
+    delete code;
   }
 
   try {
-    kernel = isa::OpenCL::compile("transpose", *code, "-cl-mad-enable -Werror", *clContext, clDevices->at(clDeviceID));
+    kernel = cache.getKernel(inPlace ? "transposeInPlace" : "transpose", configuration, generator, "-cl-mad-enable -Werror", *clContext, clDevices->at(clDeviceID));
   } catch ( isa::OpenCL::OpenCLError & err ) {
     std::cerr << err.what() << std::endl;
     return 1;
@@ -116,15 +334,52 @@ int main(int argc, char *argv[]) {
 
   // Run OpenCL kernel and CPU control
   try {
-    cl::NDRange global(isa::utils::pad(M, padding), std::ceil(static_cast< double >(isa::utils::pad(N, padding)) / conf.getNrItemsPerBlock()));
-    cl::NDRange local(conf.getNrItemsPerBlock(), 1);
+    cl::NDRange global(std::ceil(static_cast< double >(M) / conf.getTileHeight()) * conf.getNrThreads(), std::ceil(static_cast< double >(N) / conf.getTileWidth()));
+    cl::NDRange local(conf.getNrThreads(), 1);
 
-    kernel->setArg(0, input_d);
-    kernel->setArg(1, output_d);
-    
-    clQueues->at(clDeviceID)[0].enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, 0);
-    isa::OpenCL::transpose(M, N, padding, input, output_c);
-    clQueues->at(clDeviceID)[0].enqueueReadBuffer(output_d, CL_TRUE, 0, output.size() * sizeof(dataType), reinterpret_cast< void * >(output.data()));
+    if ( inPlace && (M == N) ) {
+      global = cl::NDRange(std::ceil(static_cast< double >(M) / conf.getTileWidth()) * conf.getTileWidth(), std::ceil(static_cast< double >(N) / conf.getTileWidth()));
+      local = cl::NDRange(conf.getTileWidth(), 1);
+    } else if ( inPlace ) {
+      global = cl::NDRange(isa::utils::pad(leaders.size(), conf.getNrThreads()));
+      local = cl::NDRange(conf.getNrThreads());
+    }
+
+    if ( inPlace ) {
+      kernel->setArg(0, input_d);
+      if ( M != N ) {
+        kernel->setArg(1, leaders_d);
+        kernel->setArg(2, static_cast< unsigned int >(leaders.size()));
+      }
+    } else {
+      kernel->setArg(0, input_d);
+      kernel->setArg(1, output_d);
+    }
+
+    if ( pipeline ) {
+      isa::OpenCL::transposePipeline transposer(*clContext, clQueues->at(clDeviceID), M, N, padding, panelRows, sizeof(T));
+
+      transposer.run(*kernel, conf, input.data(), output.data());
+    } else if ( ! inPlace || (M == N) || (leaders.size() > 0) ) {
+      clQueues->at(clDeviceID)[0].enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, 0);
+    }
+    if ( inPlace ) {
+      // Not the host in-place transpose, it shares the permutation leaders with the kernel
+      output_c = std::vector< T >(input.size());
+      isa::OpenCL::transpose(M, N, padding, input, output_c);
+    } else if ( cpuRecursive ) {
+      isa::OpenCL::transposeRecursive(M, N, padding, input, output_c, cpuThreads);
+    } else if ( cpuTiled ) {
+      isa::OpenCL::transpose(M, N, padding, input, output_c, cpuTile, cpuThreads);
+    } else if ( cpuFixed ) {
+      // The specialized host transpose if there is one for the shape, the tiled one with -cpu_tile otherwise
+      isa::OpenCL::transposeDispatch(M, N, padding, input, output_c, cpuTile, cpuThreads);
+    } else {
+      isa::OpenCL::transpose(M, N, padding, input, output_c);
+    }
+    if ( ! pipeline ) {
+      clQueues->at(clDeviceID)[0].enqueueReadBuffer(inPlace ? input_d : output_d, CL_TRUE, 0, output.size() * sizeof(T), reinterpret_cast< void * >(output.data()));
+    }
   } catch ( cl::Error & err ) {
     std::cerr << "OpenCL error: " << isa::utils::toString< cl_int >(err.err()) << "." << std::endl;
     return 1;
@@ -141,7 +396,7 @@ int main(int argc, char *argv[]) {
   }
   for ( unsigned int n = 0; n < N; n++ ) {
     for ( unsigned int m = 0; m < M; m++ ) {
-      if ( ! isa::utils::same(output_c[(n * isa::utils::pad(M, padding)) + m], output[(n * isa::utils::pad(M, padding)) + m]) ) {
+      if ( output_c[(n * isa::utils::pad(M, padding)) + m] != output[(n * isa::utils::pad(M, padding)) + m] ) {
         wrongItems++;
       }
       if ( printData ) {
@@ -165,3 +420,311 @@ int main(int argc, char *argv[]) {
 	return 0;
 }
 
+template< typename T > int testPermute(cl::Context & clContext, cl::Device & clDevice, cl::CommandQueue & clQueue, isa::OpenCL::kernelCache & cache, const isa::OpenCL::transposeConf & conf, const std::vector< unsigned int > & shape, const std::vector< unsigned int > & permutation, const unsigned int padding, const unsigned int vector, const bool printCode, const bool cpuTiled, const unsigned int cpuTile, const unsigned int cpuThreads) {
+  const std::string typeName = isa::OpenCL::getTransposeTypeName< T >();
+  long long unsigned int wrongItems = 0;
+  std::vector< unsigned int > permutedShape;
+  std::vector< unsigned int > axisPadding = isa::OpenCL::getPermutePadding(shape.size(), padding);
+
+  try {
+    permutedShape = isa::OpenCL::getPermuteShape(shape, permutation);
+  } catch ( std::invalid_argument & err ) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  // Allocate memory, the padding of the output is zero on both sides
+  std::vector< T > input(isa::OpenCL::getPermuteSize(shape, axisPadding));
+  std::vector< T > output(isa::OpenCL::getPermuteSize(permutedShape, axisPadding), T());
+  std::vector< T > output_c(output.size(), T());
+  cl::Buffer input_d;
+  cl::Buffer output_d;
+
+  srand(time(0));
+  for ( typename std::vector< T >::iterator item = input.begin(); item != input.end(); ++item ) {
+    *item = isa::OpenCL::getRandomTransposeValue< T >();
+  }
+  try {
+    input_d = cl::Buffer(clContext, CL_MEM_READ_ONLY, input.size() * sizeof(T), 0, 0);
+    output_d = cl::Buffer(clContext, CL_MEM_WRITE_ONLY, output.size() * sizeof(T), 0, 0);
+    clQueue.enqueueWriteBuffer(input_d, CL_FALSE, 0, input.size() * sizeof(T), reinterpret_cast< void * >(input.data()));
+    clQueue.enqueueWriteBuffer(output_d, CL_FALSE, 0, output.size() * sizeof(T), reinterpret_cast< void * >(output.data()));
+  } catch ( cl::Error & err ) {
+    std::cerr << "OpenCL error H2D transfer: " << isa::utils::toString< cl_int >(err.err()) << "." << std::endl;
+    return 1;
+  }
+
+  // Generate kernel
+  cl::Kernel * kernel;
+  std::string configuration = "permute " + isa::utils::toString(padding) + " " + isa::utils::toString(vector) + " " + typeName + " " + conf.print();
+  for ( unsigned int axis = 0; axis < shape.size(); axis++ ) {
+    configuration += " " + isa::utils::toString(shape[axis]) + ":" + isa::utils::toString(permutation[axis]);
+  }
+  auto generator = [&]() {
+    return isa::OpenCL::getPermuteOpenCL(conf, shape, axisPadding, permutation, axisPadding, vector, typeName);
+  };
+  if ( printCode ) {
+    std::string * code = generator();
+
+    std::cout << *code << std::endl;
+    delete code;
+  }
+  try {
+    kernel = cache.getKernel("permute", configuration, generator, "-cl-mad-enable -Werror", clContext, clDevice);
+  } catch ( isa::OpenCL::OpenCLError & err ) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  // Run OpenCL kernel and CPU control
+  try {
+    std::vector< unsigned int > globalSize = isa::OpenCL::getPermuteGlobalSize(conf, shape, permutation);
+    cl::NDRange global(globalSize[0], globalSize[1], globalSize[2]);
+    cl::NDRange local(conf.getNrThreads(), 1, 1);
+
+    kernel->setArg(0, input_d);
+    kernel->setArg(1, output_d);
+    clQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, 0);
+    if ( cpuTiled ) {
+      isa::OpenCL::permute(shape, axisPadding, permutation, axisPadding, input, output_c, cpuTile, cpuThreads);
+    } else {
+      isa::OpenCL::permute(shape, axisPadding, permutation, axisPadding, input, output_c);
+    }
+    clQueue.enqueueReadBuffer(output_d, CL_TRUE, 0, output.size() * sizeof(T), reinterpret_cast< void * >(output.data()));
+  } catch ( cl::Error & err ) {
+    std::cerr << "OpenCL error: " << isa::utils::toString< cl_int >(err.err()) << "." << std::endl;
+    return 1;
+  }
+  delete kernel;
+
+  for ( std::size_t item = 0; item < output.size(); item++ ) {
+    if ( output_c[item] != output[item] ) {
+      wrongItems++;
+    }
+  }
+  if ( wrongItems > 0 ) {
+    std::cout << "Wrong samples: " << wrongItems << " (" << (wrongItems * 100.0) / output.size() << "%)." << std::endl;
+  } else {
+    std::cout << "TEST PASSED." << std::endl;
+  }
+
+  return 0;
+}
+
+
+template< typename T > int testConvert(cl::Context & clContext, cl::Device & clDevice, cl::CommandQueue & clQueue, isa::OpenCL::kernelCache & cache, const isa::OpenCL::transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int vector, const float scale, const float offset, const bool printCode, const unsigned int cpuTile, const unsigned int cpuThreads) {
+  const std::string typeName = isa::OpenCL::getTransposeTypeName< T >();
+  long long unsigned int wrongItems = 0;
+  const bool scaled = (scale != 1.0f) || (offset != 0.0f);
+
+  // Allocate memory
+  std::vector< convertType > input(M * isa::utils::pad(N, padding));
+  std::vector< T > output(N * isa::utils::pad(M, padding));
+  std::vector< T > output_c(output.size());
+  cl::Buffer input_d;
+  cl::Buffer output_d;
+
+  srand(time(0));
+  for ( std::vector< convertType >::iterator item = input.begin(); item != input.end(); ++item ) {
+    *item = static_cast< convertType >(rand() % 256);
+  }
+  try {
+    input_d = cl::Buffer(clContext, CL_MEM_READ_ONLY, input.size() * sizeof(convertType), 0, 0);
+    output_d = cl::Buffer(clContext, CL_MEM_WRITE_ONLY, output.size() * sizeof(T), 0, 0);
+    clQueue.enqueueWriteBuffer(input_d, CL_FALSE, 0, input.size() * sizeof(convertType), reinterpret_cast< void * >(input.data()));
+  } catch ( cl::Error & err ) {
+    std::cerr << "OpenCL error H2D transfer: " << isa::utils::toString< cl_int >(err.err()) << "." << std::endl;
+    return 1;
+  }
+
+  // Generate kernel
+  cl::Kernel * kernel;
+  std::string configuration = isa::utils::toString(M) + " " + isa::utils::toString(N) + " " + isa::utils::toString(padding) + " " + isa::utils::toString(vector) + " " + convertTypeName + ":" + typeName + (scaled ? ":scaled " : " ") + conf.print();
+  auto generator = [&]() {
+    return isa::OpenCL::getTransposeOpenCL(conf, M, N, padding, vector, convertTypeName, typeName, scaled);
+  };
+  if ( printCode ) {
+    std::string * code = generator();
+
+    std::cout << *code << std::endl;
+    delete code;
+  }
+  try {
+    kernel = cache.getKernel("transpose", configuration, generator, "-cl-mad-enable -Werror", clContext, clDevice);
+  } catch ( isa::OpenCL::OpenCLError & err ) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  // Run OpenCL kernel and CPU control
+  try {
+    cl::NDRange global(std::ceil(static_cast< double >(M) / conf.getTileHeight()) * conf.getNrThreads(), std::ceil(static_cast< double >(N) / conf.getTileWidth()));
+    cl::NDRange local(conf.getNrThreads(), 1);
+
+    kernel->setArg(0, input_d);
+    kernel->setArg(1, output_d);
+    if ( scaled ) {
+      kernel->setArg(2, scale);
+      kernel->setArg(3, offset);
+    }
+    clQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, 0);
+    isa::OpenCL::transpose(M, N, padding, input, output_c, scale, offset, (cpuTile > 0) ? cpuTile : conf.getTileWidth(), cpuThreads);
+    clQueue.enqueueReadBuffer(output_d, CL_TRUE, 0, output.size() * sizeof(T), reinterpret_cast< void * >(output.data()));
+  } catch ( cl::Error & err ) {
+    std::cerr << "OpenCL error: " << isa::utils::toString< cl_int >(err.err()) << "." << std::endl;
+    return 1;
+  }
+  delete kernel;
+
+  for ( unsigned int n = 0; n < N; n++ ) {
+    for ( unsigned int m = 0; m < M; m++ ) {
+      if ( ! isa::utils::same(output_c[(n * isa::utils::pad(M, padding)) + m], output[(n * isa::utils::pad(M, padding)) + m]) ) {
+        wrongItems++;
+      }
+    }
+  }
+  if ( wrongItems > 0 ) {
+    std::cout << "Wrong samples: " << wrongItems << " (" << (wrongItems * 100.0) / (static_cast< long long unsigned int >(M) * N) << "%)." << std::endl;
+  } else {
+    std::cout << "TEST PASSED." << std::endl;
+  }
+
+  return 0;
+}
+
+template< typename T > int testEngine(const unsigned int clPlatformID, const unsigned int clDeviceID, const unsigned int nrQueues, const std::string & cacheDirectory, const isa::OpenCL::transposeConf & conf, const unsigned int M, const unsigned int N, const unsigned int padding, const unsigned int vector, const unsigned int nrRequests) {
+  const std::string typeName = isa::OpenCL::getTransposeTypeName< T >();
+  long long unsigned int wrongItems = 0;
+  std::vector< std::vector< T > > input(nrRequests, std::vector< T >(M * isa::utils::pad(N, padding)));
+  std::vector< std::vector< T > > output(nrRequests, std::vector< T >(N * isa::utils::pad(M, padding)));
+  std::vector< T > output_c(N * isa::utils::pad(M, padding));
+  std::vector< std::future< void > > requests;
+
+  srand(time(0));
+  for ( unsigned int request = 0; request < nrRequests; request++ ) {
+    for ( typename std::vector< T >::iterator item = input[request].begin(); item != input[request].end(); ++item ) {
+      *item = isa::OpenCL::getRandomTransposeValue< T >();
+    }
+  }
+
+  // All requests are in flight at the same time, the first one compiles the kernel
+  try {
+    isa::OpenCL::transposeEngine transposer(clPlatformID, clDeviceID, nrQueues, vector, cacheDirectory);
+
+    for ( unsigned int request = 0; request < nrRequests; request++ ) {
+      requests.push_back(transposer.submit(conf, M, N, padding, typeName, input[request], output[request]));
+    }
+    for ( unsigned int request = 0; request < nrRequests; request++ ) {
+      requests[request].get();
+    }
+    std::cout << "# engine: " << transposer.getNrKernels() << " kernels, " << transposer.getPoolSize() << " bytes in the buffer pool" << std::endl;
+  } catch ( isa::OpenCL::OpenCLError & err ) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  } catch ( cl::Error & err ) {
+    std::cerr << "OpenCL error: " << isa::utils::toString< cl_int >(err.err()) << "." << std::endl;
+    return 1;
+  }
+
+  for ( unsigned int request = 0; request < nrRequests; request++ ) {
+    isa::OpenCL::transpose(M, N, padding, input[request], output_c);
+    for ( unsigned int n = 0; n < N; n++ ) {
+      for ( unsigned int m = 0; m < M; m++ ) {
+        if ( output_c[(n * isa::utils::pad(M, padding)) + m] != output[request][(n * isa::utils::pad(M, padding)) + m] ) {
+          wrongItems++;
+        }
+      }
+    }
+  }
+  if ( wrongItems > 0 ) {
+    std::cout << "Wrong samples: " << wrongItems << " (" << (wrongItems * 100.0) / (static_cast< long long unsigned int >(M) * N * nrRequests) << "%)." << std::endl;
+  } else {
+    std::cout << "TEST PASSED." << std::endl;
+  }
+
+  return 0;
+}
+
+template< typename T > int testView(cl::Context & clContext, cl::Device & clDevice, cl::CommandQueue & clQueue, isa::OpenCL::kernelCache & cache, const isa::OpenCL::transposeConf & conf, const unsigned int M, const unsigned int N, const isa::OpenCL::matrixView & inputView, const isa::OpenCL::matrixView & outputView, const unsigned int vector, const bool printCode) {
+  const std::string typeName = isa::OpenCL::getTransposeTypeName< T >();
+  long long unsigned int wrongItems = 0;
+
+  // Allocate memory; the output outside of the view must not change
+  std::vector< T > input(isa::OpenCL::getMatrixViewSize(M, inputView));
+  std::vector< T > output(isa::OpenCL::getMatrixViewSize(N, outputView), isa::OpenCL::getTransposeFillValue< T >());
+  std::vector< T > output_c(output);
+  cl::Buffer input_d;
+  cl::Buffer output_d;
+
+  try {
+    isa::OpenCL::checkMatrixView(M, N, inputView, input.size());
+    isa::OpenCL::checkMatrixView(N, M, outputView, output.size());
+  } catch ( std::out_of_range & err ) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+  srand(time(0));
+  for ( typename std::vector< T >::iterator item = input.begin(); item != input.end(); ++item ) {
+    *item = isa::OpenCL::getRandomTransposeValue< T >();
+  }
+  try {
+    input_d = cl::Buffer(clContext, CL_MEM_READ_ONLY, input.size() * sizeof(T), 0, 0);
+    output_d = cl::Buffer(clContext, CL_MEM_READ_WRITE, output.size() * sizeof(T), 0, 0);
+    clQueue.enqueueWriteBuffer(input_d, CL_FALSE, 0, input.size() * sizeof(T), reinterpret_cast< void * >(input.data()));
+    clQueue.enqueueWriteBuffer(output_d, CL_FALSE, 0, output.size() * sizeof(T), reinterpret_cast< void * >(output.data()));
+  } catch ( cl::Error & err ) {
+    std::cerr << "OpenCL error H2D transfer: " << isa::utils::toString< cl_int >(err.err()) << "." << std::endl;
+    return 1;
+  }
+
+  // Generate kernel
+  cl::Kernel * kernel;
+  std::string configuration = isa::utils::toString(M) + " " + isa::utils::toString(N) + " " + isa::utils::toString(inputView.leadingDimension) + ":" + isa::utils::toString(outputView.leadingDimension) + " " + isa::utils::toString(vector) + " " + typeName + " " + conf.print();
+  auto generator = [&]() {
+    return isa::OpenCL::getTransposeViewOpenCL(conf, M, N, inputView.leadingDimension, outputView.leadingDimension, vector, typeName);
+  };
+  if ( printCode ) {
+    std::string * code = generator();
+
+    std::cout << *code << std::endl;
+    delete code;
+  }
+  try {
+    kernel = cache.getKernel("transposeView", configuration, generator, "-cl-mad-enable -Werror", clContext, clDevice);
+  } catch ( isa::OpenCL::OpenCLError & err ) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  // Run OpenCL kernel and CPU control
+  try {
+    cl::NDRange global(std::ceil(static_cast< double >(M) / conf.getTileHeight()) * conf.getNrThreads(), std::ceil(static_cast< double >(N) / conf.getTileWidth()));
+    cl::NDRange local(conf.getNrThreads(), 1);
+
+    kernel->setArg(0, input_d);
+    kernel->setArg(1, output_d);
+    kernel->setArg(2, static_cast< unsigned int >(isa::OpenCL::getMatrixViewOffset(inputView)));
+    kernel->setArg(3, static_cast< unsigned int >(isa::OpenCL::getMatrixViewOffset(outputView)));
+    clQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, 0);
+    isa::OpenCL::transposeHost(isa::OpenCL::HOST_NAIVE, M, N, inputView, input, outputView, output_c, 0, 1);
+    clQueue.enqueueReadBuffer(output_d, CL_TRUE, 0, output.size() * sizeof(T), reinterpret_cast< void * >(output.data()));
+  } catch ( cl::Error & err ) {
+    std::cerr << "OpenCL error: " << isa::utils::toString< cl_int >(err.err()) << "." << std::endl;
+    return 1;
+  }
+  delete kernel;
+
+  // Every element of the output, inside and outside of the view
+  for ( std::size_t item = 0; item < output.size(); item++ ) {
+    if ( output_c[item] != output[item] ) {
+      wrongItems++;
+    }
+  }
+  if ( wrongItems > 0 ) {
+    std::cout << "Wrong samples: " << wrongItems << " (" << (wrongItems * 100.0) / output.size() << "%)." << std::endl;
+  } else {
+    std::cout << "TEST PASSED." << std::endl;
+  }
+
+  return 0;
+}
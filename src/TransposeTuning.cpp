@@ -16,141 +16,590 @@
 #include <string>
 #include <vector>
 #include <exception>
+#include <stdexcept>
 #include <fstream>
 #include <iomanip>
 #include <limits>
 #include <algorithm>
+#include <cmath>
+#include <map>
+#include <future>
+#include <type_traits>
 
 #include <ArgumentList.hpp>
 #include <InitializeOpenCL.hpp>
 #include <Kernel.hpp>
 #include <Transpose.hpp>
+#include <Permute.hpp>
+#include <KernelCache.hpp>
+#include <TransposeSearch.hpp>
+#include <TransposePipeline.hpp>
+#include <TransposeSelector.hpp>
+#include <TransposePadding.hpp>
+#include <TransposeTypes.hpp>
 #include <utils.hpp>
 #include <Timer.hpp>
 #include <Stats.hpp>
 
-typedef float dataType;
-std::string typeName("float");
+// Input type of the fused conversion
+typedef unsigned char convertType;
+std::string convertTypeName("uchar");
 
-void initializeDeviceMemory(cl::Context & clContext, cl::CommandQueue * clQueue, std::vector< dataType > * input, cl::Buffer * input_d, cl::Buffer * output_d, const unsigned int output_size);
+// Kernel generated and compiled, possibly in the background
+struct compiledKernel {
+  cl::Kernel * kernel;
+  double time;
+  std::string error;
+};
+
+// The whole tuning, for elements of type T
+template< typename T > int tune(int argc, char * argv[]);
+void printUsage(const std::string & name);
+template< typename T > void initializeDeviceMemory(cl::Context & clContext, cl::CommandQueue * clQueue, std::vector< T > * input, cl::Buffer * input_d, cl::Buffer * output_d, const unsigned int output_size);
+// Median device bandwidth, in GB/s, of a copy of nrElements elements
+template< typename T > double measureCopy(cl::Context & clContext, cl::Device & clDevice, cl::CommandQueue & clQueue, cl::Buffer & input_d, cl::Buffer & output_d, const unsigned int nrElements, const unsigned int nrIterations);
+// Nearest-rank percentile, percentile in [0, 100]
+double getPercentile(std::vector< double > samples, const double percentile);
 
 int main(int argc, char * argv[]) {
+  std::string typeName;
+
+  try {
+    isa::utils::ArgumentList args(argc, argv);
+    typeName = args.getSwitchArgument< std::string >("-type");
+  } catch ( std::exception & err ) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  // Only the element type is chosen here, the tuner is compiled for each of them
+  if ( typeName == "float" ) {
+    return tune< float >(argc, argv);
+  } else if ( typeName == "double" ) {
+    return tune< double >(argc, argv);
+  } else if ( typeName == "half" ) {
+    return tune< isa::OpenCL::halfType >(argc, argv);
+  } else if ( typeName == "float2" ) {
+    return tune< isa::OpenCL::complexType >(argc, argv);
+  } else if ( typeName == "uchar" ) {
+    return tune< unsigned char >(argc, argv);
+  }
+  std::cerr << "Unknown type \"" << typeName << "\"." << std::endl;
+  return 1;
+}
+
+void printUsage(const std::string & name) {
+  std::cerr << name << " [-cache -cache_directory ...] [-selector -selector_file ...] [-batched -batches ...] [-permute -shape ... -permutation ...] [-random -samples ... | -annealing] [-time_budget -seconds ...] [-early_stop -early_threshold ...] [-prefetch -prefetch_depth ...] [-profiling | -pipeline -panel_rows ... -queues ...] [-convert -scale ... -offset ...] [-view -input_view ... -output_view ...] [-padding_search -padding_candidates ...] -type ... -iterations ... -opencl_platform ... -opencl_device ... -padding ... - vector ... [-M ... -N ...] -min_tile ... -max_tile ... -tile_inc ... -max_threads ... -max_items ... -max_vector_width ..." << std::endl;
+  std::cerr << "The type is one of float, double, half, float2 (complex) and uchar; -convert needs float or double." << std::endl;
+  std::cerr << "With -padding_search the padding is tuned too, among -padding and the best -padding_candidates multiples of it according to the padding advisor." << std::endl;
+}
+
+template< typename T > int tune(int argc, char * argv[]) {
+  const std::string typeName = isa::OpenCL::getTransposeTypeName< T >();
   bool reInit = true;
+  bool batched = false;
+  bool permute = false;
+  bool random = false;
+  bool annealing = false;
+  bool earlyStop = false;
+  bool profiling = false;
+  bool pipeline = false;
+  bool convert = false;
+  bool view = false;
+  bool paddingSearch = false;
 	unsigned int nrIterations = 0;
 	unsigned int clPlatformID = 0;
 	unsigned int clDeviceID = 0;
-	unsigned int minThreads = 0;
+	unsigned int minTile = 0;
+	unsigned int maxTile = 0;
+  unsigned int tileInc = 0;
 	unsigned int maxThreads = 0;
-  unsigned int threadInc = 0;
+  unsigned int maxItems = 0;
+  unsigned int maxVectorWidth = 0;
   unsigned int padding = 0;
   unsigned int vector = 0;
   unsigned int M = 0;
   unsigned int N = 0;
+  unsigned int nrBatches = 1;
+  unsigned int nrSamples = 0;
+  unsigned int prefetchDepth = 0;
+  unsigned int panelRows = 0;
+  unsigned int nrQueues = 1;
+  unsigned int nrPaddings = 0;
+  unsigned int nrTried = 0;
+  unsigned int nrStopped = 0;
+  double timeBudget = 0.0;
+  double earlyThreshold = 0.0;
+  double compileTime = 0.0;
+  double waitTime = 0.0;
+  double copyGBs = 0.0;
+  float scale = 1.0f;
+  float offset = 0.0f;
+  std::string cacheDirectory;
+  std::string selectorFilename;
+  std::vector< unsigned int > shape;
+  std::vector< unsigned int > permutation;
+  std::vector< unsigned int > axisPadding;
+  isa::OpenCL::matrixView inputView;
+  isa::OpenCL::matrixView outputView;
   isa::OpenCL::transposeConf conf;
   cl::Event event;
+  cl::CommandQueue profilingQueue;
 
 	try {
     isa::utils::ArgumentList args(argc, argv);
 
+    if ( args.getSwitch("-cache") ) {
+      cacheDirectory = args.getSwitchArgument< std::string >("-cache_directory");
+    }
+    if ( args.getSwitch("-selector") ) {
+      selectorFilename = args.getSwitchArgument< std::string >("-selector_file");
+    }
+    batched = args.getSwitch("-batched");
+    if ( batched ) {
+      nrBatches = args.getSwitchArgument< unsigned int >("-batches");
+    }
+    permute = args.getSwitch("-permute");
+    if ( permute ) {
+      shape = isa::OpenCL::readPermuteAxes(args.getSwitchArgument< std::string >("-shape"));
+      permutation = isa::OpenCL::readPermuteAxes(args.getSwitchArgument< std::string >("-permutation"));
+    }
+    random = args.getSwitch("-random");
+    if ( random ) {
+      nrSamples = args.getSwitchArgument< unsigned int >("-samples");
+    }
+    annealing = args.getSwitch("-annealing");
+    if ( args.getSwitch("-time_budget") ) {
+      timeBudget = args.getSwitchArgument< double >("-seconds");
+    }
+    earlyStop = args.getSwitch("-early_stop");
+    if ( earlyStop ) {
+      earlyThreshold = args.getSwitchArgument< double >("-early_threshold");
+    }
+    profiling = args.getSwitch("-profiling");
+    pipeline = args.getSwitch("-pipeline");
+    if ( pipeline ) {
+      panelRows = args.getSwitchArgument< unsigned int >("-panel_rows");
+      nrQueues = args.getSwitchArgument< unsigned int >("-queues");
+    }
+    convert = args.getSwitch("-convert");
+    if ( convert ) {
+      scale = args.getSwitchArgument< float >("-scale");
+      offset = args.getSwitchArgument< float >("-offset");
+    }
+    view = args.getSwitch("-view");
+    if ( view ) {
+      inputView = isa::OpenCL::readMatrixView(args.getSwitchArgument< std::string >("-input_view"));
+      outputView = isa::OpenCL::readMatrixView(args.getSwitchArgument< std::string >("-output_view"));
+    }
+    paddingSearch = args.getSwitch("-padding_search");
+    if ( paddingSearch ) {
+      nrPaddings = args.getSwitchArgument< unsigned int >("-padding_candidates");
+    }
+    if ( args.getSwitch("-prefetch") ) {
+      prefetchDepth = args.getSwitchArgument< unsigned int >("-prefetch_depth");
+    }
 		nrIterations = args.getSwitchArgument< unsigned int >("-iterations");
 		clPlatformID = args.getSwitchArgument< unsigned int >("-opencl_platform");
 		clDeviceID = args.getSwitchArgument< unsigned int >("-opencl_device");
     padding = args.getSwitchArgument< unsigned int >("-padding");
     vector = args.getSwitchArgument< unsigned int >("-vector");
-    M = args.getSwitchArgument< unsigned int >("-M");
-    N = args.getSwitchArgument< unsigned int >("-N");
-		minThreads = args.getSwitchArgument< unsigned int >("-min_threads");
+    if ( permute ) {
+      // The tiles span the axes contiguous in the output and in the input
+      axisPadding = isa::OpenCL::getPermutePadding(shape.size(), padding);
+      M = isa::OpenCL::getPermuteShape(shape, permutation).back();
+      N = shape.back();
+    } else {
+      M = args.getSwitchArgument< unsigned int >("-M");
+      N = args.getSwitchArgument< unsigned int >("-N");
+    }
+		minTile = args.getSwitchArgument< unsigned int >("-min_tile");
+		maxTile = args.getSwitchArgument< unsigned int >("-max_tile");
+    tileInc = args.getSwitchArgument< unsigned int >("-tile_inc");
 		maxThreads = args.getSwitchArgument< unsigned int >("-max_threads");
-    threadInc = args.getSwitchArgument< unsigned int >("-thread_inc");
+    maxItems = args.getSwitchArgument< unsigned int >("-max_items");
+    maxVectorWidth = args.getSwitchArgument< unsigned int >("-max_vector_width");
 	} catch ( isa::utils::EmptyCommandLine & err ) {
-		std::cerr << argv[0] << " -iterations ... -opencl_platform ... -opencl_device ... -padding ... - vector ... -M ... -N ... -min_threads ... -max_threads ... -thread_inc ..." << std::endl;
+		printUsage(argv[0]);
 		return 1;
 	} catch ( std::exception & err ) {
 		std::cerr << err.what() << std::endl;
 		return 1;
 	}
 
+  if ( ! selectorFilename.empty() && (batched || permute || pipeline) ) {
+    std::cerr << "The selector only stores configurations of the transpose, it can not be combined with -batched, -permute or -pipeline." << std::endl;
+    return 1;
+  }
+  if ( convert && (batched || permute || pipeline) ) {
+    std::cerr << "The conversion can not be combined with -batched, -permute or -pipeline." << std::endl;
+    return 1;
+  }
+  if ( convert && ! std::is_floating_point< T >::value ) {
+    std::cerr << "The conversion is only available to float and double." << std::endl;
+    return 1;
+  }
+  if ( view && (batched || permute || pipeline || convert || ! selectorFilename.empty()) ) {
+    std::cerr << "Views can not be combined with -batched, -permute, -pipeline, -convert or -selector." << std::endl;
+    return 1;
+  }
+  if ( paddingSearch && (batched || permute || pipeline || convert || view) ) {
+    std::cerr << "The padding search can not be combined with -batched, -permute, -pipeline, -convert or -view." << std::endl;
+    return 1;
+  }
+  const bool scaled = convert && ((scale != 1.0f) || (offset != 0.0f));
+  if ( pipeline ) {
+    if ( profiling || batched || permute ) {
+      std::cerr << "The pipeline can not be combined with -profiling, -batched or -permute." << std::endl;
+      return 1;
+    }
+    panelRows = std::min(panelRows, M);
+  }
+
 	// Initialize OpenCL
 	cl::Context clContext;
 	std::vector< cl::Platform > * clPlatforms = new std::vector< cl::Platform >();
 	std::vector< cl::Device > * clDevices = new std::vector< cl::Device >();
 	std::vector< std::vector< cl::CommandQueue > > * clQueues = 0;
 
+  // Paddings to tune, the one from the command line first
+  std::vector< unsigned int > paddings(1, padding);
+  unsigned int advisedPadding = padding;
+
+  if ( paddingSearch ) {
+    // There is no device yet to ask, and OpenCL does not tell the memory partitions anyway
+    std::vector< unsigned int > advised = isa::OpenCL::getPaddingCandidates(M, N, sizeof(T), padding, nrPaddings, isa::OpenCL::getDevicePaddingModel());
+
+    if ( advised.size() > 0 ) {
+      advisedPadding = advised.front();
+    }
+    for ( std::vector< unsigned int >::const_iterator candidatePadding = advised.begin(); candidatePadding != advised.end(); ++candidatePadding ) {
+      if ( std::find(paddings.begin(), paddings.end(), *candidatePadding) == paddings.end() ) {
+        paddings.push_back(*candidatePadding);
+      }
+    }
+  }
+  // The buffers are large enough for every padding
+  unsigned int maxInputStride = 0;
+  unsigned int maxOutputStride = 0;
+
+  for ( std::vector< unsigned int >::const_iterator candidatePadding = paddings.begin(); candidatePadding != paddings.end(); ++candidatePadding ) {
+    maxInputStride = std::max(maxInputStride, isa::utils::pad(N, *candidatePadding));
+    maxOutputStride = std::max(maxOutputStride, isa::utils::pad(M, *candidatePadding));
+  }
+
 	// Allocate memory
-  std::vector< dataType > input = std::vector< dataType >(M * isa::utils::pad(N, padding));
+  std::vector< T > input = std::vector< T >(nrBatches * M * maxInputStride);
+  std::size_t outputSize = nrBatches * N * maxOutputStride;
+  long long unsigned int nrElements = static_cast< long long unsigned int >(M) * N * nrBatches;
+
+  if ( permute ) {
+    input = std::vector< T >(isa::OpenCL::getPermuteSize(shape, axisPadding));
+    outputSize = isa::OpenCL::getPermuteSize(isa::OpenCL::getPermuteShape(shape, permutation), axisPadding);
+    nrElements = 1;
+    for ( unsigned int axis = 0; axis < shape.size(); axis++ ) {
+      nrElements *= shape[axis];
+    }
+  } else if ( view ) {
+    input = std::vector< T >(isa::OpenCL::getMatrixViewSize(M, inputView));
+    outputSize = isa::OpenCL::getMatrixViewSize(N, outputView);
+    try {
+      isa::OpenCL::checkMatrixView(M, N, inputView, input.size());
+      isa::OpenCL::checkMatrixView(N, M, outputView, outputSize);
+    } catch ( std::out_of_range & err ) {
+      std::cerr << err.what() << std::endl;
+      return 1;
+    }
+  }
   cl::Buffer input_d;
   cl::Buffer output_d;
 
 	srand(time(0));
-  for ( unsigned int m = 0; m < M; m++ ) {
-    for ( unsigned int n = 0; n < N; n++ ) {
-      input[(m * isa::utils::pad(N, padding)) + n] = static_cast< dataType >(rand() % 10);
-    }
+  for ( typename std::vector< T >::iterator item = input.begin(); item != input.end(); ++item ) {
+    *item = isa::OpenCL::getRandomTransposeValue< T >();
 	}
 
-  // Copy data structures to device
-  try {
-  } catch ( cl::Error & err ) {
-    std::cerr << "OpenCL error H2D transfer: " << isa::utils::toString(err.err()) << "." << std::endl;
-    return 1;
+  // Host output of the pipeline, the other modes leave the data on the device
+  std::vector< T > output;
+  isa::OpenCL::transposePipeline * transposer = 0;
+
+  if ( pipeline ) {
+    output = std::vector< T >(outputSize);
   }
 
-	// Find the parameters
-	std::vector< unsigned int > threads;
-	for ( unsigned int items = minThreads; items <= maxThreads; items += threadInc ) {
-		if ( (M % items) == 0 ) {
-			threads.push_back(items);
-		}
-	}
+  isa::OpenCL::kernelCache cache(cacheDirectory);
+
+	// Find the parameters, configurationPaddings[i] is the padding of configurations[i]
+	std::vector< isa::OpenCL::transposeConf > configurations;
+  std::vector< unsigned int > configurationPaddings;
+  for ( std::vector< unsigned int >::const_iterator candidatePadding = paddings.begin(); candidatePadding != paddings.end(); ++candidatePadding ) {
+    // Row strides of input and output
+    const unsigned int inputStride = view ? inputView.leadingDimension : isa::utils::pad(N, *candidatePadding);
+    const unsigned int outputStride = view ? outputView.leadingDimension : isa::utils::pad(M, *candidatePadding);
+
+    for ( unsigned int width = minTile; width <= maxTile; width += tileInc ) {
+      conf.setTileWidth(width);
+      for ( unsigned int height = minTile; height <= maxTile; height += tileInc ) {
+        conf.setTileHeight(height);
+        for ( unsigned int items = 1; items <= maxItems; items++ ) {
+          if ( ((width * height) % items) != 0 || ((width * height) / items) > maxThreads ) {
+            continue;
+          }
+          conf.setNrItemsPerThread(items);
+          for ( unsigned int localPadding = 0; localPadding <= 1; localPadding++ ) {
+            conf.setLocalPadding(localPadding);
+            // OpenCL vector types only exist with 2, 4, 8 and 16 elements, and elements that are vectors already can not be widened
+            for ( unsigned int vectorWidth = 1; vectorWidth <= maxVectorWidth && vectorWidth <= 16; vectorWidth *= 2 ) {
+              if ( (vectorWidth > 1) && (isa::OpenCL::getTransposeTypeWidth(typeName) > 1) ) {
+                break;
+              }
+              if ( (width % vectorWidth) != 0 || (height % vectorWidth) != 0 || (inputStride % vectorWidth) != 0 || (outputStride % vectorWidth) != 0 ) {
+                continue;
+              }
+              conf.setVectorWidth(vectorWidth);
+              for ( unsigned int directWrite = 0; directWrite <= 1; directWrite++ ) {
+                conf.setDirectWrite(directWrite);
+                for ( unsigned int diagonal = 0; diagonal <= 1; diagonal++ ) {
+                  conf.setDiagonal(diagonal);
+                  configurations.push_back(conf);
+                  configurationPaddings.push_back(*candidatePadding);
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
 
 	std::cout << std::fixed << std::endl;
-	std::cout << "# M N nrItemsPerBlock GB/s time stdDeviation COV" << std::endl << std::endl;
+  std::cout << "# type " << typeName << " (" << sizeof(T) << " bytes)" << std::endl;
+  if ( permute ) {
+    std::cout << "# permute shape";
+    for ( unsigned int axis = 0; axis < shape.size(); axis++ ) {
+      std::cout << " " << shape[axis];
+    }
+    std::cout << " permutation";
+    for ( unsigned int axis = 0; axis < permutation.size(); axis++ ) {
+      std::cout << " " << permutation[axis];
+    }
+    std::cout << " (M and N are the axes contiguous in the output and in the input)" << std::endl;
+  } else if ( batched ) {
+    std::cout << "# batches " << nrBatches << " (GB/s is the aggregate over the batch)" << std::endl;
+  } else if ( convert ) {
+    std::cout << "# conversion from " << convertTypeName << " to " << typeName << ", scale " << scale << " offset " << offset << " (GB/s counts the input and output types)" << std::endl;
+  } else if ( view ) {
+    std::cout << "# view of input " << inputView.firstRow << ":" << inputView.firstColumn << ":" << inputView.leadingDimension << " output " << outputView.firstRow << ":" << outputView.firstColumn << ":" << outputView.leadingDimension << " (row:column:leading dimension)" << std::endl;
+  } else if ( pipeline ) {
+    std::cout << "# pipeline of " << panelRows << " rows per panel on " << nrQueues << " queues (GB/s is host to host, transfers included)" << std::endl;
+  }
+  if ( paddingSearch ) {
+    std::cout << "# paddings";
+    for ( unsigned int candidatePadding = 0; candidatePadding < paddings.size(); candidatePadding++ ) {
+      std::cout << " " << paddings[candidatePadding];
+    }
+    std::cout << " (the first from the command line, the others from the padding advisor)" << std::endl;
+  }
+	std::cout << "# M N";
+  if ( paddingSearch ) {
+    std::cout << " padding";
+  }
+  std::cout << " tileWidth tileHeight nrItemsPerThread localPadding vectorWidth directWrite diagonal GB/s time stdDeviation COV";
+  if ( profiling ) {
+    // Times are in seconds, kernelGB/s uses the median device time
+    std::cout << " kernelGB/s kernelMin kernelP50 kernelP95 kernelP99 hostMin hostP50 hostP95 hostP99 launchOverhead copy%";
+  }
+  std::cout << std::endl << std::endl;
+
+  isa::OpenCL::transposeSearch * search = 0;
+  if ( random ) {
+    search = new isa::OpenCL::randomSearch(configurations, nrSamples, time(0));
+  } else if ( annealing ) {
+    search = new isa::OpenCL::annealingSearch(configurations, timeBudget, time(0));
+  } else {
+    search = new isa::OpenCL::exhaustiveSearch(configurations);
+  }
+  const std::string kernelName = permute ? "permute" : (batched ? "transposeBatched" : (view ? "transposeView" : "transpose"));
+  auto compileKernel = [&](const isa::OpenCL::transposeConf candidate, const unsigned int candidatePadding) {
+    compiledKernel compiled = {0, 0.0, std::string()};
+    isa::utils::Timer timer;
+    // The pipeline transposes one panel at a time
+    const unsigned int kernelRows = pipeline ? panelRows : M;
+    std::string confString = isa::utils::toString(kernelRows) + " " + isa::utils::toString(N) + " " + isa::utils::toString(candidatePadding) + " " + isa::utils::toString(vector) + " " + typeName + " " + candidate.print();
+    if ( convert ) {
+      confString = convertTypeName + (scaled ? ":scaled " : " ") + confString;
+    } else if ( view ) {
+      confString = "view " + isa::utils::toString(inputView.leadingDimension) + ":" + isa::utils::toString(outputView.leadingDimension) + " " + confString;
+    }
+    if ( permute ) {
+      confString = "permute " + confString;
+      for ( unsigned int axis = 0; axis < shape.size(); axis++ ) {
+        confString += " " + isa::utils::toString(shape[axis]) + ":" + isa::utils::toString(permutation[axis]);
+      }
+    }
+    auto generator = [&]() {
+      if ( permute ) {
+        return isa::OpenCL::getPermuteOpenCL(candidate, shape, axisPadding, permutation, axisPadding, vector, typeName);
+      } else if ( batched ) {
+        return isa::OpenCL::getTransposeBatchedOpenCL(candidate, M, N, candidatePadding, vector, typeName, M * isa::utils::pad(N, candidatePadding), N * isa::utils::pad(M, candidatePadding));
+      } else if ( convert ) {
+        return isa::OpenCL::getTransposeOpenCL(candidate, M, N, candidatePadding, vector, convertTypeName, typeName, scaled);
+      } else if ( view ) {
+        return isa::OpenCL::getTransposeViewOpenCL(candidate, M, N, inputView.leadingDimension, outputView.leadingDimension, vector, typeName);
+      }
+      return isa::OpenCL::getTransposeOpenCL(candidate, kernelRows, N, candidatePadding, vector, typeName);
+    };
+
+    timer.start();
+    try {
+      compiled.kernel = cache.getKernel(kernelName, confString, generator, "-cl-mad-enable -Werror", clContext, clDevices->at(clDeviceID));
+    } catch ( isa::OpenCL::OpenCLError & err ) {
+      compiled.error = err.what();
+    }
+    timer.stop();
+    compiled.time = timer.getLastRunTime();
+    return compiled;
+  };
+  // Kernels of the upcoming candidates, compiled while the current one runs
+  std::map< unsigned int, std::future< compiledKernel > > prefetched;
+  isa::utils::Timer searchTimer;
+  unsigned int candidate = 0;
 
-  for ( std::vector< unsigned int >::iterator nrThreads = threads.begin(); nrThreads != threads.end(); ++nrThreads ) {
-    conf.setNrItemsPerBlock(*nrThreads);
-    // Generate kernel
-    double gbs = isa::utils::giga(static_cast< long long unsigned int >(M) * N * 2 * sizeof(dataType));
+  searchTimer.start();
+  while ( search->next(candidate) ) {
+    conf = configurations[candidate];
+    double gbs = isa::utils::giga(nrElements * 2 * sizeof(T));
+    if ( convert ) {
+      gbs = isa::utils::giga(nrElements * (sizeof(convertType) + sizeof(T)));
+    }
+    bool stopped = false;
     isa::utils::Timer timer;
-    cl::Kernel * kernel;
-    std::string * code = isa::OpenCL::getTransposeOpenCL(conf, M, N, padding, vector, typeName);
+    isa::utils::Timer waitTimer;
+    compiledKernel compiled;
 
     if ( reInit ) {
       delete clQueues;
       clQueues = new std::vector< std::vector< cl::CommandQueue > >();
-      isa::OpenCL::initializeOpenCL(clPlatformID, 1, clPlatforms, &clContext, clDevices, clQueues);
+      isa::OpenCL::initializeOpenCL(clPlatformID, nrQueues, clPlatforms, &clContext, clDevices, clQueues);
+      if ( (typeName == "double") && (clDevices->at(clDeviceID).getInfo< CL_DEVICE_EXTENSIONS >().find("cl_khr_fp64") == std::string::npos) ) {
+        std::cerr << "The device does not support double." << std::endl;
+        return -1;
+      }
       try {
-        initializeDeviceMemory(clContext, &(clQueues->at(clDeviceID)[0]), &input, &input_d, &output_d, N * isa::utils::pad(M, padding));
+        // With -convert the kernels read convertType elements from input_d, which is sized for T and so large enough
+        initializeDeviceMemory(clContext, &(clQueues->at(clDeviceID)[0]), &input, &input_d, &output_d, outputSize);
       } catch ( cl::Error & err ) {
         return -1;
       }
+      if ( profiling ) {
+        profilingQueue = cl::CommandQueue(clContext, clDevices->at(clDeviceID), CL_QUEUE_PROFILING_ENABLE);
+        if ( copyGBs == 0.0 ) {
+          try {
+            copyGBs = measureCopy< T >(clContext, clDevices->at(clDeviceID), profilingQueue, input_d, output_d, std::min(input.size(), outputSize), std::max(nrIterations, 1u));
+          } catch ( cl::Error & err ) {
+            std::cerr << "OpenCL error copy baseline: " << isa::utils::toString(err.err()) << "." << std::endl;
+            return -1;
+          } catch ( isa::OpenCL::OpenCLError & err ) {
+            std::cerr << err.what() << std::endl;
+            return -1;
+          }
+          std::cout << "# copy baseline " << std::setprecision(3) << copyGBs << " GB/s" << std::endl << std::endl;
+        }
+      }
+      if ( pipeline ) {
+        delete transposer;
+        try {
+          transposer = new isa::OpenCL::transposePipeline(clContext, clQueues->at(clDeviceID), M, N, padding, panelRows, sizeof(T));
+        } catch ( cl::Error & err ) {
+          std::cerr << "OpenCL error allocating the pipeline: " << isa::utils::toString(err.err()) << "." << std::endl;
+          return -1;
+        }
+      }
       reInit = false;
     }
-    try {
-      kernel = isa::OpenCL::compile("transpose", *code, "-cl-mad-enable -Werror", clContext, clDevices->at(clDeviceID));
-    } catch ( isa::OpenCL::OpenCLError & err ) {
-      std::cerr << err.what() << std::endl;
-      delete code;
-      break;
+    cl::CommandQueue & clQueue = profiling ? profilingQueue : clQueues->at(clDeviceID)[0];
+    // Generate and compile the kernels that come next in the background
+    if ( prefetchDepth > 0 ) {
+      std::vector< unsigned int > upcoming = search->lookahead(prefetchDepth);
+
+      for ( std::vector< unsigned int >::const_iterator next = upcoming.begin(); next != upcoming.end(); ++next ) {
+        if ( prefetched.count(*next) == 0 && *next != candidate ) {
+          prefetched.insert(std::make_pair(*next, std::async(std::launch::async, compileKernel, configurations[*next], configurationPaddings[*next])));
+        }
+      }
+    }
+    waitTimer.start();
+    if ( prefetched.count(candidate) > 0 ) {
+      compiled = prefetched[candidate].get();
+      prefetched.erase(candidate);
+    } else {
+      compiled = compileKernel(conf, configurationPaddings[candidate]);
     }
-    delete code;
+    waitTimer.stop();
+    waitTime += waitTimer.getLastRunTime();
+    compileTime += compiled.time;
+    if ( compiled.kernel == 0 ) {
+      // A configuration the device cannot build, e.g. too much local memory, does not stop the search
+      std::cerr << compiled.error << std::endl;
+      search->update(candidate, 0.0);
+      continue;
+    }
+    cl::Kernel * kernel = compiled.kernel;
+
+    cl::NDRange global(std::ceil(static_cast< double >(M) / conf.getTileHeight()) * conf.getNrThreads(), std::ceil(static_cast< double >(N) / conf.getTileWidth()));
+    cl::NDRange local(conf.getNrThreads(), 1);
 
-    cl::NDRange global(M, std::ceil(static_cast< double >(N) / conf.getNrItemsPerBlock()));
-    cl::NDRange local(conf.getNrItemsPerBlock(), 1);
+    if ( permute ) {
+      std::vector< unsigned int > globalSize = isa::OpenCL::getPermuteGlobalSize(conf, shape, permutation);
+
+      global = cl::NDRange(globalSize[0], globalSize[1], globalSize[2]);
+      local = cl::NDRange(conf.getNrThreads(), 1, 1);
+    } else if ( batched ) {
+      global = cl::NDRange(std::ceil(static_cast< double >(M) / conf.getTileHeight()) * conf.getNrThreads(), std::ceil(static_cast< double >(N) / conf.getTileWidth()), nrBatches);
+      local = cl::NDRange(conf.getNrThreads(), 1, 1);
+    }
 
     kernel->setArg(0, input_d);
     kernel->setArg(1, output_d);
+    if ( scaled ) {
+      kernel->setArg(2, scale);
+      kernel->setArg(3, offset);
+    } else if ( view ) {
+      kernel->setArg(2, static_cast< unsigned int >(isa::OpenCL::getMatrixViewOffset(inputView)));
+      kernel->setArg(3, static_cast< unsigned int >(isa::OpenCL::getMatrixViewOffset(outputView)));
+    }
+
+    std::vector< double > kernelTimes;
+    std::vector< double > hostTimes;
 
     try {
       // Warm-up run
-      clQueues->at(clDeviceID)[0].finish();
-      clQueues->at(clDeviceID)[0].enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, &event);
-      event.wait();
+      clQueue.finish();
+      if ( pipeline ) {
+        transposer->run(*kernel, conf, input.data(), output.data());
+      } else {
+        clQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, &event);
+        event.wait();
+      }
       // Tuning runs
       for ( unsigned int iteration = 0; iteration < nrIterations; iteration++ ) {
         timer.start();
-        clQueues->at(clDeviceID)[0].enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, &event);
-        event.wait();
+        if ( pipeline ) {
+          transposer->run(*kernel, conf, input.data(), output.data());
+        } else {
+          clQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, &event);
+          event.wait();
+        }
         timer.stop();
+        if ( profiling ) {
+          kernelTimes.push_back((event.getProfilingInfo< CL_PROFILING_COMMAND_END >() - event.getProfilingInfo< CL_PROFILING_COMMAND_START >()) * 1.0e-09);
+          hostTimes.push_back(timer.getLastRunTime());
+        }
+        // Stop after the first tenth of the runs if clearly worse than the best so far
+        if ( earlyStop && (iteration + 1 == std::max(nrIterations / 10, 1u)) && (iteration + 1 < nrIterations) && (gbs / timer.getAverageTime() < earlyThreshold * search->getBestGBs()) ) {
+          stopped = true;
+          break;
+        }
       }
     } catch ( cl::Error & err ) {
       std::cerr << "OpenCL error kernel execution (";
@@ -164,25 +613,88 @@ int main(int argc, char * argv[]) {
       break;
     }
     delete kernel;
+    nrTried++;
+
+    if ( stopped ) {
+      nrStopped++;
+      search->update(candidate, 0.0);
+      std::cout << "# stopped early: " << M << " " << N << " ";
+      if ( paddingSearch ) {
+        std::cout << configurationPaddings[candidate] << " ";
+      }
+      std::cout << conf.print() << " ";
+      std::cout << std::setprecision(3);
+      std::cout << gbs / timer.getAverageTime() << std::endl;
+    } else {
+      search->update(candidate, gbs / timer.getAverageTime());
+      std::cout << M << " " << N << " ";
+      if ( paddingSearch ) {
+        std::cout << configurationPaddings[candidate] << " ";
+      }
+      std::cout << conf.print() << " ";
+      std::cout << std::setprecision(3);
+      std::cout << gbs / timer.getAverageTime() << " ";
+      std::cout << std::setprecision(6);
+      std::cout << timer.getAverageTime() << " " << timer.getStandardDeviation() << " " << timer.getCoefficientOfVariation();
+      if ( profiling ) {
+        double kernelMedian = getPercentile(kernelTimes, 50.0);
+
+        std::cout << std::setprecision(3);
+        std::cout << " " << gbs / kernelMedian;
+        std::cout << std::setprecision(9);
+        std::cout << " " << getPercentile(kernelTimes, 0.0) << " " << kernelMedian << " " << getPercentile(kernelTimes, 95.0) << " " << getPercentile(kernelTimes, 99.0);
+        std::cout << " " << getPercentile(hostTimes, 0.0) << " " << getPercentile(hostTimes, 50.0) << " " << getPercentile(hostTimes, 95.0) << " " << getPercentile(hostTimes, 99.0);
+        std::cout << " " << getPercentile(hostTimes, 50.0) - kernelMedian;
+        std::cout << std::setprecision(2);
+        std::cout << " " << ((gbs / kernelMedian) * 100.0) / copyGBs;
+      }
+      std::cout << std::endl;
+    }
+    searchTimer.stop();
+    if ( timeBudget > 0.0 && searchTimer.getTotalTime() >= timeBudget ) {
+      break;
+    }
+    searchTimer.start();
+  }
+  // Kernels compiled for candidates that were never run
+  for ( std::map< unsigned int, std::future< compiledKernel > >::iterator next = prefetched.begin(); next != prefetched.end(); ++next ) {
+    delete next->second.get().kernel;
+  }
 
-    std::cout << M << " " << N << " ";
-    std::cout << conf.print() << " ";
-    std::cout << std::setprecision(3);
-    std::cout << gbs / timer.getAverageTime() << " ";
-    std::cout << std::setprecision(6);
-    std::cout << timer.getAverageTime() << " " << timer.getStandardDeviation() << " " << timer.getCoefficientOfVariation() << std::endl;
+	std::cout << std::endl;
+  std::cout << std::setprecision(6);
+  std::cout << "# search: " << nrTried << " of " << configurations.size() << " configurations tried, " << nrStopped << " stopped early" << std::endl;
+  std::cout << "# kernel cache: " << cache.getNrHits() << " hits, " << cache.getNrMisses() << " misses, " << compileTime << " s generating and compiling (" << waitTime << " s waiting)" << std::endl;
+  if ( paddingSearch && search->getBestGBs() > 0.0 ) {
+    std::cout << "# padding: " << configurationPaddings[search->getBest()] << " measured best, " << advisedPadding << " advised, " << padding << " from the command line" << std::endl;
   }
+  // Add the best configuration to the selector file, keeping what was tuned before
+  if ( ! selectorFilename.empty() && search->getBestGBs() > 0.0 ) {
+    isa::OpenCL::transposeSelector selector;
 
+    try {
+      if ( std::ifstream(selectorFilename).good() ) {
+        selector.read(selectorFilename);
+      }
+      selector.insert(clDevices->at(clDeviceID).getInfo< CL_DEVICE_NAME >(), convert ? convertTypeName + ":" + typeName : typeName, M, N, configurationPaddings[search->getBest()], configurations[search->getBest()], search->getBestGBs());
+      selector.write(selectorFilename);
+      std::cout << "# selector: " << selector.getNrEntries() << " configurations in " << selectorFilename << std::endl;
+    } catch ( std::runtime_error & err ) {
+      std::cerr << err.what() << std::endl;
+    }
+  }
 	std::cout << std::endl;
+  delete search;
+  delete transposer;
 
 	return 0;
 }
 
-void initializeDeviceMemory(cl::Context & clContext, cl::CommandQueue * clQueue, std::vector< dataType > * input, cl::Buffer * input_d, cl::Buffer * output_d, const unsigned int output_size) {
+template< typename T > void initializeDeviceMemory(cl::Context & clContext, cl::CommandQueue * clQueue, std::vector< T > * input, cl::Buffer * input_d, cl::Buffer * output_d, const unsigned int output_size) {
   try {
-    *input_d = cl::Buffer(clContext, CL_MEM_READ_ONLY, input->size() * sizeof(dataType), 0, 0);
-    *output_d = cl::Buffer(clContext, CL_MEM_WRITE_ONLY, output_size * sizeof(dataType), 0, 0);
-    clQueue->enqueueWriteBuffer(*input_d, CL_FALSE, 0, input->size() * sizeof(dataType), reinterpret_cast< void * >(input->data()));
+    *input_d = cl::Buffer(clContext, CL_MEM_READ_ONLY, input->size() * sizeof(T), 0, 0);
+    *output_d = cl::Buffer(clContext, CL_MEM_WRITE_ONLY, output_size * sizeof(T), 0, 0);
+    clQueue->enqueueWriteBuffer(*input_d, CL_FALSE, 0, input->size() * sizeof(T), reinterpret_cast< void * >(input->data()));
     clQueue->finish();
   } catch ( cl::Error & err ) {
     std::cerr << "OpenCL error: " << isa::utils::toString(err.err()) << "." << std::endl;
@@ -190,3 +702,36 @@ void initializeDeviceMemory(cl::Context & clContext, cl::CommandQueue * clQueue,
   }
 }
 
+template< typename T > double measureCopy(cl::Context & clContext, cl::Device & clDevice, cl::CommandQueue & clQueue, cl::Buffer & input_d, cl::Buffer & output_d, const unsigned int nrElements, const unsigned int nrIterations) {
+  std::string * code = isa::OpenCL::getCopyOpenCL(nrElements, isa::OpenCL::getTransposeTypeName< T >());
+  cl::Kernel * kernel = isa::OpenCL::compile("copy", *code, "-cl-mad-enable -Werror", clContext, clDevice);
+  cl::NDRange global(isa::utils::pad(nrElements, 256));
+  cl::NDRange local(256);
+  std::vector< double > times;
+  cl::Event event;
+
+  delete code;
+  kernel->setArg(0, input_d);
+  kernel->setArg(1, output_d);
+  // Warm-up run
+  clQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, &event);
+  event.wait();
+  for ( unsigned int iteration = 0; iteration < nrIterations; iteration++ ) {
+    clQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, &event);
+    event.wait();
+    times.push_back((event.getProfilingInfo< CL_PROFILING_COMMAND_END >() - event.getProfilingInfo< CL_PROFILING_COMMAND_START >()) * 1.0e-09);
+  }
+  delete kernel;
+
+  return isa::utils::giga(static_cast< long long unsigned int >(nrElements) * 2 * sizeof(T)) / getPercentile(times, 50.0);
+}
+
+double getPercentile(std::vector< double > samples, const double percentile) {
+  if ( samples.size() == 0 ) {
+    return 0.0;
+  }
+  std::sort(samples.begin(), samples.end());
+  unsigned int rank = std::ceil((percentile / 100.0) * samples.size());
+
+  return samples[std::max(rank, 1u) - 1];
+}
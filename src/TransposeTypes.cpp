@@ -0,0 +1,165 @@
+// Copyright 2015 Alessio Sclocco <a.sclocco@vu.nl>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include <TransposeTypes.hpp>
+
+namespace isa {
+namespace OpenCL {
+
+bool operator==(const halfType & left, const halfType & right) {
+  return left.bits == right.bits;
+}
+
+bool operator!=(const halfType & left, const halfType & right) {
+  return left.bits != right.bits;
+}
+
+std::ostream & operator<<(std::ostream & stream, const halfType & value) {
+  return stream << halfToFloat(value);
+}
+
+halfType floatToHalf(const float value) {
+  std::uint32_t bits = 0;
+  halfType half;
+
+  std::memcpy(&bits, &value, sizeof(float));
+  const std::uint16_t sign = (bits >> 16) & 0x8000;
+  const int exponent = static_cast< int >((bits >> 23) & 0xff) - 127 + 15;
+  std::uint32_t mantissa = bits & 0x7fffff;
+
+  if ( ((bits >> 23) & 0xff) == 0xff ) {
+    // Infinity, or a quiet NaN
+    half.bits = sign | 0x7c00 | ((mantissa != 0) ? 0x200 : 0);
+  } else if ( exponent >= 31 ) {
+    half.bits = sign | 0x7c00;
+  } else if ( exponent <= 0 ) {
+    // Subnormal, or too small even for that
+    if ( exponent < -10 ) {
+      half.bits = sign;
+    } else {
+      const unsigned int shift = 14 - exponent;
+      std::uint32_t remainder = 0;
+
+      mantissa |= 0x800000;
+      remainder = mantissa & ((1u << shift) - 1);
+      half.bits = mantissa >> shift;
+      if ( (remainder > (1u << (shift - 1))) || ((remainder == (1u << (shift - 1))) && (half.bits & 1)) ) {
+        half.bits++;
+      }
+      half.bits |= sign;
+    }
+  } else {
+    // Rounding up can carry into the exponent, up to infinity, as it should
+    half.bits = (exponent << 10) | (mantissa >> 13);
+    if ( ((mantissa & 0x1fff) > 0x1000) || (((mantissa & 0x1fff) == 0x1000) && (half.bits & 1)) ) {
+      half.bits++;
+    }
+    half.bits |= sign;
+  }
+  return half;
+}
+
+float halfToFloat(const halfType value) {
+  const std::uint32_t sign = static_cast< std::uint32_t >(value.bits & 0x8000) << 16;
+  const std::uint32_t exponent = (value.bits >> 10) & 0x1f;
+  const std::uint32_t mantissa = value.bits & 0x3ff;
+  std::uint32_t bits = 0;
+  float result = 0.0f;
+
+  if ( exponent == 0 ) {
+    result = std::ldexp(static_cast< float >(mantissa), -24);
+    return (sign != 0) ? -result : result;
+  } else if ( exponent == 0x1f ) {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+  std::memcpy(&result, &bits, sizeof(float));
+  return result;
+}
+
+const std::vector< std::string > & getTransposeTypeNames() {
+  static const std::vector< std::string > typeNames = {"float", "double", "half", "float2", "uchar"};
+
+  return typeNames;
+}
+
+template< > std::string getTransposeTypeName< float >() {
+  return "float";
+}
+
+template< > std::string getTransposeTypeName< double >() {
+  return "double";
+}
+
+template< > std::string getTransposeTypeName< unsigned char >() {
+  return "uchar";
+}
+
+template< > std::string getTransposeTypeName< halfType >() {
+  return "half";
+}
+
+template< > std::string getTransposeTypeName< complexType >() {
+  return "float2";
+}
+
+template< > float getRandomTransposeValue< float >() {
+  return static_cast< float >(rand() % 10);
+}
+
+template< > double getRandomTransposeValue< double >() {
+  return static_cast< double >(rand() % 10);
+}
+
+template< > unsigned char getRandomTransposeValue< unsigned char >() {
+  return static_cast< unsigned char >(rand() % 10);
+}
+
+template< > halfType getRandomTransposeValue< halfType >() {
+  return floatToHalf(static_cast< float >(rand() % 10));
+}
+
+template< > complexType getRandomTransposeValue< complexType >() {
+  float real = static_cast< float >(rand() % 10);
+
+  return complexType(real, static_cast< float >(rand() % 10));
+}
+
+template< > float getTransposeFillValue< float >() {
+  return -1.0f;
+}
+
+template< > double getTransposeFillValue< double >() {
+  return -1.0;
+}
+
+template< > unsigned char getTransposeFillValue< unsigned char >() {
+  return 255;
+}
+
+template< > halfType getTransposeFillValue< halfType >() {
+  return floatToHalf(-1.0f);
+}
+
+template< > complexType getTransposeFillValue< complexType >() {
+  return complexType(-1.0f, -1.0f);
+}
+
+} // OpenCL
+} // isa
@@ -25,34 +25,79 @@
 #include <ArgumentList.hpp>
 #include <utils.hpp>
 #include <Transpose.hpp>
+#include <Permute.hpp>
 
 
 int main(int argc, char *argv[]) {
+  bool permute = false;
+  bool convert = false;
+  bool scale = false;
+  bool view = false;
   unsigned int padding = 0;
   unsigned int vector = 0;
   unsigned int M = 0;
   unsigned int N = 0;
+  unsigned int inputLeadingDimension = 0;
+  unsigned int outputLeadingDimension = 0;
   std::string typeName;
+  std::string inputTypeName;
+  std::vector< unsigned int > shape;
+  std::vector< unsigned int > permutation;
   isa::OpenCL::transposeConf conf;
 
 	try {
     isa::utils::ArgumentList args(argc, argv);
+    permute = args.getSwitch("-permute");
+    if ( permute ) {
+      shape = isa::OpenCL::readPermuteAxes(args.getSwitchArgument< std::string >("-shape"));
+      permutation = isa::OpenCL::readPermuteAxes(args.getSwitchArgument< std::string >("-permutation"));
+    }
+    convert = args.getSwitch("-convert");
+    if ( convert ) {
+      inputTypeName = args.getSwitchArgument< std::string >("-input_type");
+      scale = args.getSwitch("-scale");
+    }
+    view = args.getSwitch("-view");
+    if ( view ) {
+      inputLeadingDimension = args.getSwitchArgument< unsigned int >("-input_ld");
+      outputLeadingDimension = args.getSwitchArgument< unsigned int >("-output_ld");
+    }
     typeName = args.getSwitchArgument< std::string >("-type");
     padding = args.getSwitchArgument< unsigned int >("-padding");
     vector = args.getSwitchArgument< unsigned int >("-vector");
-    conf.setNrItemsPerBlock(args.getSwitchArgument< unsigned int >("-threads"));
-    M = args.getSwitchArgument< unsigned int >("-M");
-    N = args.getSwitchArgument< unsigned int >("-N");
+    conf.setTileWidth(args.getSwitchArgument< unsigned int >("-width"));
+    conf.setTileHeight(args.getSwitchArgument< unsigned int >("-height"));
+    conf.setNrItemsPerThread(args.getSwitchArgument< unsigned int >("-items"));
+    conf.setLocalPadding(args.getSwitchArgument< unsigned int >("-local_padding"));
+    conf.setVectorWidth(args.getSwitchArgument< unsigned int >("-vector_width"));
+    conf.setDirectWrite(args.getSwitchArgument< unsigned int >("-direct_write"));
+    conf.setDiagonal(args.getSwitchArgument< unsigned int >("-diagonal"));
+    if ( ! permute ) {
+      M = args.getSwitchArgument< unsigned int >("-M");
+      N = args.getSwitchArgument< unsigned int >("-N");
+    }
 	} catch  ( isa::utils::SwitchNotFound & err ) {
     std::cerr << err.what() << std::endl;
     return 1;
   }catch ( std::exception & err ) {
-    std::cerr << "Usage: " << argv[0] << " -type ... -padding ... -vector ... -threads ... -M ... -N ..." << std::endl;
+    std::cerr << "Usage: " << argv[0] << " [-permute -shape ... -permutation ...] [-convert -input_type ... [-scale]] [-view -input_ld ... -output_ld ...] -type ... -padding ... -vector ... -width ... -height ... -items ... -local_padding ... -vector_width ... -direct_write ... -diagonal ... [-M ... -N ...]" << std::endl;
 		return 1;
 	}
 
   // Generate kernel
-  std::string * code = isa::OpenCL::getTransposeOpenCL(conf, M, N, padding, vector, typeName);
+  std::string * code = 0;
+
+  if ( permute ) {
+    std::vector< unsigned int > axisPadding = isa::OpenCL::getPermutePadding(shape.size(), padding);
+
+    code = isa::OpenCL::getPermuteOpenCL(conf, shape, axisPadding, permutation, axisPadding, vector, typeName);
+  } else if ( view ) {
+    code = isa::OpenCL::getTransposeViewOpenCL(conf, M, N, inputLeadingDimension, outputLeadingDimension, vector, typeName);
+  } else if ( convert ) {
+    code = isa::OpenCL::getTransposeOpenCL(conf, M, N, padding, vector, inputTypeName, typeName, scale);
+  } else {
+    code = isa::OpenCL::getTransposeOpenCL(conf, M, N, padding, vector, typeName);
+  }
   std::cout << *code << std::endl;
 
 	return 0;